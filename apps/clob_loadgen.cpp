@@ -0,0 +1,316 @@
+#include "clob/oe_protocol.hpp"
+#include "clob/order.hpp"
+#include "clob/types.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace clob;
+
+// Load generator for clob_server. Each connection keeps `window` orders in
+// flight, one per slot, and cycles every slot through Add -> (Amend) ->
+// Cancel; one Add in eight is marketable. Round-trip latency is measured from
+// the send() carrying a request to the reply that completes it.
+
+static inline std::uint64_t ns_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static inline std::uint32_t lcg(std::uint32_t& s) {
+  s = 1664525u * s + 1013904223u;
+  return s;
+}
+
+enum class Stage : std::uint8_t { Idle, Adding, Amending, Cancelling };
+
+struct Slot {
+  Stage stage{Stage::Idle};
+  std::uint64_t sent_ns{0};
+};
+
+struct Client {
+  int fd{-1};
+  OrderId first_id{};
+  std::vector<Slot> slots;
+  std::size_t requests_left{};
+  std::size_t in_flight{0};
+  std::uint32_t rng{};
+
+  std::vector<char> in;
+  std::size_t in_end{0};
+  std::vector<char> out;
+  std::vector<std::size_t> pending;   // slots whose request is in out
+};
+
+struct Totals {
+  std::uint64_t requests{0};
+  std::uint64_t fills{0};
+  std::uint64_t rejects{0};
+  std::vector<std::uint64_t> latencies;
+};
+
+template <typename T>
+static void queue(Client& c, std::size_t slot, const T& msg) {
+  const auto* bytes = reinterpret_cast<const char*>(&msg);
+  c.out.insert(c.out.end(), bytes, bytes + sizeof(T));
+  c.pending.push_back(slot);
+  ++c.in_flight;
+}
+
+static void queue_add(Client& c, std::size_t slot, OeType type) {
+  const std::uint32_t r = lcg(c.rng);
+  const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+  const bool marketable = (r >> 1) % 8 == 0;
+
+  PriceTicks price;
+  if (marketable) price = side == Side::Buy ? 20000 : 1;
+  else            price = side == Side::Buy ? static_cast<PriceTicks>(9999 - (r >> 4) % 20)
+                                            : static_cast<PriceTicks>(10001 + (r >> 4) % 20);
+
+  queue(c, slot, OeOrder{.type = type, .side = static_cast<std::uint8_t>(side),
+                         .order_id = c.first_id + static_cast<OrderId>(slot), .price_ticks = price,
+                         .qty = 1 + static_cast<Qty>((r >> 12) % 5)});
+  c.slots[slot].stage = type == OeType::Add ? Stage::Adding : Stage::Amending;
+}
+
+static void queue_cancel(Client& c, std::size_t slot) {
+  queue(c, slot, OeId{.type = OeType::Cancel, .order_id = c.first_id + static_cast<OrderId>(slot)});
+  c.slots[slot].stage = Stage::Cancelling;
+}
+
+static void start_slot(Client& c, std::size_t slot) {
+  if (c.requests_left == 0) return;
+  --c.requests_left;
+  queue_add(c, slot, OeType::Add);
+}
+
+// One send() per client per wakeup; requests are stamped when it goes out.
+static bool flush(Client& c) {
+  if (c.out.empty()) return true;
+
+  const std::uint64_t now = ns_now();
+  for (std::size_t slot : c.pending) c.slots[slot].sent_ns = now;
+  c.pending.clear();
+
+  std::size_t sent = 0;
+  while (sent < c.out.size()) {
+    const ssize_t n = ::send(c.fd, c.out.data() + sent, c.out.size() - sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) {
+        // Replies are tiny and the window is bounded, so the socket buffer
+        // only fills if the server stops reading.
+        ::usleep(50);
+        continue;
+      }
+      std::perror("send");
+      return false;
+    }
+    sent += static_cast<std::size_t>(n);
+  }
+  c.out.clear();
+  return true;
+}
+
+static void complete(Client& c, std::size_t slot, Totals& t) {
+  t.latencies.push_back(ns_now() - c.slots[slot].sent_ns);
+  ++t.requests;
+  --c.in_flight;
+}
+
+static void on_reply(Client& c, const char* msg, Totals& t) {
+  OeId head;
+  std::memcpy(&head, msg, sizeof(head));
+  const auto type = head.type;
+
+  if (type == OeType::Fill) {
+    ++t.fills;
+    return;
+  }
+  if (type == OeType::Done) return;
+
+  if (head.order_id < c.first_id || head.order_id - c.first_id >= c.slots.size()) return;
+  const std::size_t slot = head.order_id - c.first_id;
+  Slot& s = c.slots[slot];
+
+  if (type == OeType::RejectAdd || type == OeType::RejectCancel) ++t.rejects;
+
+  switch (s.stage) {
+    case Stage::Adding:
+      complete(c, slot, t);
+      if (type == OeType::AckAdd && (lcg(c.rng) & 3u) == 0 && c.requests_left > 0) {
+        --c.requests_left;
+        queue_add(c, slot, OeType::Amend);
+      } else if (type == OeType::AckAdd && c.requests_left > 0) {
+        --c.requests_left;
+        queue_cancel(c, slot);
+      } else {
+        s.stage = Stage::Idle;
+        start_slot(c, slot);
+      }
+      break;
+    case Stage::Amending:
+      // The cancel half's ack is followed by the add half's reply.
+      if (type == OeType::AckCancel) return;
+      complete(c, slot, t);
+      if (type == OeType::AckAdd && c.requests_left > 0) {
+        --c.requests_left;
+        queue_cancel(c, slot);
+      } else {
+        s.stage = Stage::Idle;
+        start_slot(c, slot);
+      }
+      break;
+    case Stage::Cancelling:
+      complete(c, slot, t);
+      s.stage = Stage::Idle;
+      start_slot(c, slot);
+      break;
+    case Stage::Idle:
+      break;
+  }
+}
+
+static int connect_loopback(std::uint16_t port) {
+  const int fd = ::socket(AF_INET, SOCK_STREAM, 0);
+  if (fd < 0) return -1;
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::connect(fd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+    ::close(fd);
+    return -1;
+  }
+
+  const int one = 1;
+  ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+  return fd;
+}
+
+int main(int argc, char** argv) {
+  const auto port = static_cast<std::uint16_t>(argc > 1 ? std::atoi(argv[1]) : 9100);
+  const std::size_t connections = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+  const std::size_t requests = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 200'000;
+  const std::size_t window = argc > 4 ? std::strtoull(argv[4], nullptr, 10) : 16;
+
+  if (connections == 0 || window == 0) {
+    std::cerr << "usage: clob_loadgen [port] [connections] [requests_per_connection] [window]\n";
+    return 1;
+  }
+
+  const int ep = ::epoll_create1(0);
+  std::vector<Client> clients(connections);
+  Totals totals;
+  totals.latencies.reserve(connections * requests);
+
+  for (std::size_t i = 0; i < connections; ++i) {
+    Client& c = clients[i];
+    c.fd = connect_loopback(port);
+    if (c.fd < 0) {
+      std::perror("connect");
+      return 1;
+    }
+    // Disjoint id ranges so connections never collide on an order id.
+    c.first_id = static_cast<OrderId>(1 + i * window);
+    c.slots.resize(window);
+    c.requests_left = requests;
+    c.rng = static_cast<std::uint32_t>(17 + i);
+    c.in.resize(64 * 1024);
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u64 = i;
+    ::epoll_ctl(ep, EPOLL_CTL_ADD, c.fd, &ev);
+  }
+
+  const std::uint64_t t0 = ns_now();
+  for (Client& c : clients) {
+    for (std::size_t slot = 0; slot < window; ++slot) start_slot(c, slot);
+    if (!flush(c)) return 1;
+  }
+
+  std::size_t busy = connections;
+  epoll_event events[64];
+  while (busy > 0) {
+    const int n = ::epoll_wait(ep, events, 64, 1000);
+    if (n < 0 && errno == EINTR) continue;
+    if (n <= 0) {
+      std::cerr << "clob_loadgen: no reply from server\n";
+      return 1;
+    }
+
+    for (int i = 0; i < n; ++i) {
+      Client& c = clients[events[i].data.u64];
+      const ssize_t r = ::recv(c.fd, c.in.data() + c.in_end, c.in.size() - c.in_end, 0);
+      if (r <= 0) {
+        std::cerr << "clob_loadgen: connection closed\n";
+        return 1;
+      }
+      c.in_end += static_cast<std::size_t>(r);
+
+      std::size_t pos = 0;
+      while (pos < c.in_end) {
+        const std::size_t size = oe_message_size(static_cast<std::uint8_t>(c.in[pos]));
+        if (size == 0) {
+          std::cerr << "clob_loadgen: bad reply type\n";
+          return 1;
+        }
+        if (c.in_end - pos < size) break;
+        on_reply(c, c.in.data() + pos, totals);
+        pos += size;
+      }
+      std::memmove(c.in.data(), c.in.data() + pos, c.in_end - pos);
+      c.in_end -= pos;
+
+      if (!flush(c)) return 1;
+      if (c.in_flight == 0 && c.requests_left == 0 && c.fd >= 0) {
+        ::close(c.fd);
+        c.fd = -1;
+        --busy;
+      }
+    }
+  }
+  const std::uint64_t t1 = ns_now();
+
+  auto& lat = totals.latencies;
+  std::sort(lat.begin(), lat.end());
+  auto pct = [&](double p) {
+    if (lat.empty()) return std::uint64_t{0};
+    return lat[static_cast<std::size_t>(p * double(lat.size() - 1))];
+  };
+
+  const double sec = double(t1 - t0) * 1e-9;
+  std::cout << "clob_loadgen connections=" << connections
+            << " window=" << window
+            << " requests=" << totals.requests
+            << " sec=" << sec
+            << " requests_per_s=" << (sec > 0.0 ? double(totals.requests) / sec : 0.0)
+            << " fills=" << totals.fills
+            << " rejects=" << totals.rejects
+            << "\n";
+  std::cout << "clob_loadgen rtt p50_ns=" << pct(0.50)
+            << " p99_ns=" << pct(0.99)
+            << " p999_ns=" << pct(0.999)
+            << " max_ns=" << (lat.empty() ? 0 : lat.back())
+            << "\n";
+  return 0;
+}
@@ -98,6 +98,7 @@ int main() {
   book.add_limit(6, 20, Side::Sell, 1000);
 
   std::cout << "hash=" << sink.h << " events=" << sink.count << "\n";
+  std::cout << "state_hash=" << book.state_hash() << "\n";
   return 0;
 }
 
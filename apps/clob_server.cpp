@@ -0,0 +1,416 @@
+#include "clob/book.hpp"
+#include "clob/oe_protocol.hpp"
+#include "clob/types.hpp"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+using namespace clob;
+
+// Loopback order-entry front-end for one Book. Single-threaded: each
+// epoll_wait wakeup drains every readable connection into the book, then
+// flushes each connection that has replies with one send().
+//
+// Each connection is a Book session, so closing it cancels its orders. Every
+// Add is answered with exactly one AckAdd or RejectAdd, after any fills it
+// caused; Cancel with AckCancel or RejectCancel; Amend like a Cancel
+// followed, if that succeeded, by an Add.
+
+static volatile std::sig_atomic_t g_stop = 0;
+
+static void on_signal(int) { g_stop = 1; }
+
+class OeServer final : public Book::EventSink {
+public:
+  OeServer(std::size_t max_orders, SessionId max_sessions)
+    : book_(max_orders, BookConfig{.max_sessions = max_sessions})
+    , owner_(max_orders + 1, 0)
+    , conns_(max_sessions)
+  {
+    book_.set_sink(this);
+    for (SessionId s = max_sessions - 1; s > 0; --s) free_sessions_.push_back(s);
+  }
+
+  bool listen(std::uint16_t port);
+  void run();
+
+  void on_ack_add(const Book::AckAddEvent& e) override;
+  void on_reject_add(const Book::RejectAddEvent& e) override;
+  void on_ack_cancel(const Book::AckCancelEvent& e) override;
+  void on_reject_cancel(const Book::RejectCancelEvent& e) override;
+  void on_trade(const Book::TradeEvent& e) override;
+  void on_done(const Book::DoneEvent& e) override;
+  // Only sent when a connection closes; there is nobody left to tell.
+  void on_mass_cancel(const Book::MassCancelEvent&) override {}
+
+private:
+  static constexpr std::size_t in_capacity = 64 * 1024;
+  // Stop reading from a connection that has this much unsent output.
+  static constexpr std::size_t out_high_water = 1024 * 1024;
+  static constexpr int max_events = 64;
+
+  struct Connection {
+    int fd{-1};
+    std::vector<char> in;
+    std::size_t in_end{0};
+    std::vector<char> out;
+    std::size_t out_sent{0};
+    bool dirty{false};
+    std::uint32_t interest{0};
+  };
+
+  Book book_;
+  // Session that placed each live order id; stale entries are harmless since
+  // the book decides whether the id is live.
+  std::vector<SessionId> owner_;
+  std::vector<Connection> conns_;
+  std::vector<SessionId> free_sessions_;
+  std::vector<SessionId> dirty_;
+
+  int listen_fd_{-1};
+  int epoll_fd_{-1};
+
+  // Request being applied: rejects go back to its sender, and an Add that
+  // filled completely (which the book does not ack) is acked here.
+  SessionId current_{0};
+  bool acked_{false};
+
+  std::uint64_t wakeups_{0};
+  std::uint64_t messages_in_{0};
+  std::uint64_t messages_out_{0};
+  std::uint64_t sends_{0};
+
+  void accept_all();
+  void close_session(SessionId s);
+  void on_readable(SessionId s);
+  void apply(SessionId s, const char* msg);
+  void apply_add(SessionId s, const OeOrder& m);
+  void flush(SessionId s);
+  void set_interest(Connection& c, SessionId s, std::uint32_t interest);
+
+  template <typename T>
+  void send(SessionId s, const T& msg);
+};
+
+template <typename T>
+void OeServer::send(SessionId s, const T& msg)
+{
+  Connection& c = conns_[s];
+  if (c.fd < 0) return;
+
+  const auto* bytes = reinterpret_cast<const char*>(&msg);
+  c.out.insert(c.out.end(), bytes, bytes + sizeof(T));
+  ++messages_out_;
+  if (!c.dirty) {
+    c.dirty = true;
+    dirty_.push_back(s);
+  }
+}
+
+void OeServer::on_ack_add(const Book::AckAddEvent& e)
+{
+  owner_[e.order_id] = current_;
+  acked_ = true;
+  send(current_, OeId{.type = OeType::AckAdd, .order_id = e.order_id});
+}
+
+void OeServer::on_reject_add(const Book::RejectAddEvent& e)
+{
+  acked_ = true;
+  send(current_, oe_reject(OeType::RejectAdd, e.order_id, e.reason));
+}
+
+void OeServer::on_ack_cancel(const Book::AckCancelEvent& e)
+{
+  send(current_, OeId{.type = OeType::AckCancel, .order_id = e.order_id});
+}
+
+void OeServer::on_reject_cancel(const Book::RejectCancelEvent& e)
+{
+  send(current_, oe_reject(OeType::RejectCancel, e.order_id, e.reason));
+}
+
+void OeServer::on_trade(const Book::TradeEvent& e)
+{
+  send(owner_[e.resting_id], OeFill{.aggressor = 0, .order_id = e.resting_id, .price_ticks = e.price, .qty = e.qty});
+  send(current_, OeFill{.aggressor = 1, .order_id = e.incoming_id, .price_ticks = e.price, .qty = e.qty});
+}
+
+void OeServer::on_done(const Book::DoneEvent& e)
+{
+  send(owner_[e.order_id], OeId{.type = OeType::Done, .order_id = e.order_id});
+}
+
+bool OeServer::listen(std::uint16_t port)
+{
+  listen_fd_ = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+  if (listen_fd_ < 0) {
+    std::perror("socket");
+    return false;
+  }
+
+  const int one = 1;
+  ::setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+  sockaddr_in addr{};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(port);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  if (::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0) {
+    std::perror("bind");
+    return false;
+  }
+  if (::listen(listen_fd_, 128) != 0) {
+    std::perror("listen");
+    return false;
+  }
+
+  epoll_fd_ = ::epoll_create1(0);
+  if (epoll_fd_ < 0) {
+    std::perror("epoll_create1");
+    return false;
+  }
+
+  // Session 0 is the untagged session, so its slot stands for the listener.
+  epoll_event ev{};
+  ev.events = EPOLLIN;
+  ev.data.u32 = 0;
+  return ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev) == 0;
+}
+
+void OeServer::accept_all()
+{
+  for (;;) {
+    const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK);
+    if (fd < 0) return;
+
+    if (free_sessions_.empty()) {
+      ::close(fd);
+      continue;
+    }
+
+    const int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    const SessionId s = free_sessions_.back();
+    free_sessions_.pop_back();
+
+    Connection& c = conns_[s];
+    c.fd = fd;
+    c.in.resize(in_capacity);
+    c.in_end = 0;
+    c.out.clear();
+    c.out_sent = 0;
+    c.interest = EPOLLIN;
+
+    epoll_event ev{};
+    ev.events = EPOLLIN;
+    ev.data.u32 = s;
+    ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+  }
+}
+
+void OeServer::close_session(SessionId s)
+{
+  Connection& c = conns_[s];
+  if (c.fd < 0) return;
+
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, c.fd, nullptr);
+  ::close(c.fd);
+  c.fd = -1;
+  c.out.clear();
+  c.out_sent = 0;
+
+  (void)book_.cancel_session(s);
+  free_sessions_.push_back(s);
+}
+
+void OeServer::on_readable(SessionId s)
+{
+  Connection& c = conns_[s];
+
+  const ssize_t n = ::recv(c.fd, c.in.data() + c.in_end, c.in.size() - c.in_end, 0);
+  if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+    close_session(s);
+    return;
+  }
+  if (n < 0) return;
+  c.in_end += static_cast<std::size_t>(n);
+
+  std::size_t pos = 0;
+  while (pos < c.in_end) {
+    const std::size_t size = oe_message_size(static_cast<std::uint8_t>(c.in[pos]));
+    if (size == 0) {
+      std::cerr << "session " << s << ": bad message type " << int(std::uint8_t(c.in[pos])) << "\n";
+      close_session(s);
+      return;
+    }
+    if (c.in_end - pos < size) break;
+    apply(s, c.in.data() + pos);
+    pos += size;
+  }
+
+  std::memmove(c.in.data(), c.in.data() + pos, c.in_end - pos);
+  c.in_end -= pos;
+}
+
+void OeServer::apply(SessionId s, const char* msg)
+{
+  ++messages_in_;
+  current_ = s;
+
+  const auto type = static_cast<std::uint8_t>(msg[0]);
+  switch (static_cast<OeType>(type)) {
+    case OeType::Add: {
+      OeOrder m;
+      std::memcpy(&m, msg, sizeof(m));
+      apply_add(s, m);
+      break;
+    }
+    case OeType::Cancel:
+    case OeType::Amend: {
+      // A Cancel is the leading OeId part of an OeOrder.
+      OeOrder m;
+      std::memcpy(&m, msg, oe_message_size(type));
+      // Only the session that placed an order may cancel or amend it.
+      if (m.order_id >= owner_.size() || owner_[m.order_id] != s) {
+        send(s, oe_reject(OeType::RejectCancel, m.order_id, "unknown order_id"));
+        break;
+      }
+      if (book_.cancel(m.order_id) && m.type == OeType::Amend) apply_add(s, m);
+      break;
+    }
+    default:
+      // Server-to-client types; ignored.
+      break;
+  }
+}
+
+void OeServer::apply_add(SessionId s, const OeOrder& m)
+{
+  if (m.side > static_cast<std::uint8_t>(Side::Sell)) {
+    send(s, oe_reject(OeType::RejectAdd, m.order_id, "invalid side"));
+    return;
+  }
+
+  acked_ = false;
+  const auto res = book_.add_limit(m.order_id, m.qty, static_cast<Side>(m.side), m.price_ticks, s);
+  if (res.accepted && !acked_) send(s, OeId{.type = OeType::AckAdd, .order_id = m.order_id});
+}
+
+void OeServer::set_interest(Connection& c, SessionId s, std::uint32_t interest)
+{
+  if (c.interest == interest) return;
+  c.interest = interest;
+
+  epoll_event ev{};
+  ev.events = interest;
+  ev.data.u32 = s;
+  ::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd, &ev);
+}
+
+void OeServer::flush(SessionId s)
+{
+  Connection& c = conns_[s];
+  c.dirty = false;
+  if (c.fd < 0) return;
+
+  while (c.out_sent < c.out.size()) {
+    const ssize_t n = ::send(c.fd, c.out.data() + c.out_sent, c.out.size() - c.out_sent, MSG_NOSIGNAL);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      if (errno == EAGAIN) break;
+      close_session(s);
+      return;
+    }
+    ++sends_;
+    c.out_sent += static_cast<std::size_t>(n);
+  }
+
+  const std::size_t pending = c.out.size() - c.out_sent;
+  if (pending == 0) {
+    c.out.clear();
+    c.out_sent = 0;
+  }
+
+  std::uint32_t interest = pending < out_high_water ? std::uint32_t{EPOLLIN} : 0u;
+  if (pending != 0) interest |= EPOLLOUT;
+  set_interest(c, s, interest);
+}
+
+void OeServer::run()
+{
+  epoll_event events[max_events];
+
+  while (!g_stop) {
+    const int n = ::epoll_wait(epoll_fd_, events, max_events, 100);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      std::perror("epoll_wait");
+      break;
+    }
+    if (n == 0) continue;
+    ++wakeups_;
+
+    for (int i = 0; i < n; ++i) {
+      const SessionId s = events[i].data.u32;
+      if (s == 0) {
+        accept_all();
+        continue;
+      }
+      if (conns_[s].fd < 0) continue;  // closed earlier in this batch
+
+      if (events[i].events & EPOLLIN) {
+        on_readable(s);
+      } else if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+        close_session(s);
+        continue;
+      }
+      if ((events[i].events & EPOLLOUT) && !conns_[s].dirty) {
+        conns_[s].dirty = true;
+        dirty_.push_back(s);
+      }
+    }
+
+    for (SessionId s : dirty_) flush(s);
+    dirty_.clear();
+  }
+
+  std::cout << "wakeups=" << wakeups_
+            << " messages_in=" << messages_in_
+            << " messages_out=" << messages_out_
+            << " sends=" << sends_
+            << " messages_in_per_wakeup=" << (wakeups_ ? double(messages_in_) / double(wakeups_) : 0.0)
+            << " messages_out_per_send=" << (sends_ ? double(messages_out_) / double(sends_) : 0.0)
+            << "\n";
+}
+
+int main(int argc, char** argv) {
+  const auto port = static_cast<std::uint16_t>(argc > 1 ? std::atoi(argv[1]) : 9100);
+  const std::size_t max_orders = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1'000'000;
+
+  std::signal(SIGINT, on_signal);
+  std::signal(SIGTERM, on_signal);
+
+  OeServer server(max_orders, 1024);
+  if (!server.listen(port)) return 1;
+
+  std::cout << "clob_server listening on 127.0.0.1:" << port << "\n";
+  std::cout.flush();
+  server.run();
+  return 0;
+}
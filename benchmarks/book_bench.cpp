@@ -1,6 +1,9 @@
 #include "clob/book.hpp"
+#include "clob/fixed_book.hpp"
+#include "clob/trade_analytics.hpp"
 #include "clob/types.hpp"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <cstddef>
@@ -8,6 +11,9 @@
 #include <cstdlib>
 #include <iostream>
 #include <new>
+#include <string_view>
+#include <thread>
+#include <utility>
 #include <vector>
 
 using namespace clob;
@@ -33,9 +39,11 @@ static inline void do_not_optimize(T const& value) {
 }
 
 static std::atomic<std::uint64_t> g_new_calls{0};
+static thread_local std::uint64_t t_new_calls = 0;
 
 void* operator new(std::size_t n) {
   g_new_calls.fetch_add(1, std::memory_order_relaxed);
+  ++t_new_calls;
   if (void* p = std::malloc(n)) return p;
   std::abort();
 }
@@ -43,6 +51,7 @@ void operator delete(void* p) noexcept { std::free(p); }
 
 void* operator new[](std::size_t n) {
   g_new_calls.fetch_add(1, std::memory_order_relaxed);
+  ++t_new_calls;
   if (void* p = std::malloc(n)) return p;
   std::abort();
 }
@@ -163,8 +172,12 @@ static void bench_cancel(std::size_t max_orders,
 static void bench_marketable_match(std::size_t max_orders,
                                    std::size_t warmup_ops,
                                    std::size_t ops,
-                                   OrderId start_id) {
+                                   OrderId start_id,
+                                   const char* name = "marketable_match",
+                                   Book::EventSink* sink = nullptr,
+                                   AnalyticsSink* analytics = nullptr) {
   Book book(max_orders);
+  book.set_sink(sink);
   OrderId id = start_id;
 
   for (int i = 0; i < 1000; ++i) {
@@ -181,6 +194,7 @@ static void bench_marketable_match(std::size_t max_orders,
 
   const std::uint64_t t0 = ns_now();
   for (std::size_t i = 0; i < ops; ++i) {
+    if (analytics) analytics->set_time(i * 100);
     const auto res = book.add_limit(id++, 1, Side::Buy, 20000);
     do_not_optimize(res.accepted);
   }
@@ -188,16 +202,80 @@ static void bench_marketable_match(std::size_t max_orders,
 
   const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
 
-  report("marketable_match", ops, (t1 - t0));
-  check_allocs("marketable_match", new_before, new_after);
+  report(name, ops, (t1 - t0));
+  check_allocs(name, new_before, new_after);
 }
 
-static void bench_mixed_stream(std::size_t max_orders,
-                               std::size_t warmup_iters,
-                               std::size_t iters,
-                               OrderId start_id) {
+static void bench_pro_rata_match(std::size_t max_orders,
+                                 std::size_t warmup_ops,
+                                 std::size_t ops,
+                                 OrderId start_id) {
+  BookConfig cfg;
+  cfg.match_policy = MatchPolicy::ProRata;
+  Book book(max_orders, cfg);
+  OrderId id = start_id;
+
+  // 100 equal resting orders; each incoming buy is split ten ways per order.
+  for (int i = 0; i < 100; ++i) {
+    const auto res = book.add_limit(id++, 1'000'000'000, Side::Sell, 10000);
+    do_not_optimize(res.accepted);
+  }
+
+  for (std::size_t i = 0; i < warmup_ops; ++i) {
+    const auto res = book.add_limit(id++, 1000, Side::Buy, 20000);
+    do_not_optimize(res.accepted);
+  }
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t i = 0; i < ops; ++i) {
+    const auto res = book.add_limit(id++, 1000, Side::Buy, 20000);
+    do_not_optimize(res.accepted);
+  }
+  const std::uint64_t t1 = ns_now();
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("pro_rata_match", ops, (t1 - t0));
+  check_allocs("pro_rata_match", new_before, new_after);
+}
+
+static void bench_iceberg_refill(std::size_t max_orders,
+                                 std::size_t warmup_ops,
+                                 std::size_t ops,
+                                 OrderId start_id) {
   Book book(max_orders);
+  OrderId id = start_id;
+
+  // Every incoming buy consumes a whole display slice, so each op refills.
+  for (int i = 0; i < 1000; ++i) {
+    const auto res = book.add_iceberg(id++, 1'000'000, Side::Sell, 10000, 1);
+    do_not_optimize(res.accepted);
+  }
+
+  for (std::size_t i = 0; i < warmup_ops; ++i) {
+    const auto res = book.add_limit(id++, 1, Side::Buy, 20000);
+    do_not_optimize(res.accepted);
+  }
 
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t i = 0; i < ops; ++i) {
+    const auto res = book.add_limit(id++, 1, Side::Buy, 20000);
+    do_not_optimize(res.accepted);
+  }
+  const std::uint64_t t1 = ns_now();
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("iceberg_refill", ops, (t1 - t0));
+  check_allocs("iceberg_refill", new_before, new_after);
+}
+
+template <typename B>
+static void run_mixed_stream(B& book, std::size_t warmup_iters, std::size_t iters, OrderId start_id, const char* name) {
   std::uint32_t rng = 42;
   OrderId id = start_id;
 
@@ -240,8 +318,605 @@ static void bench_mixed_stream(std::size_t max_orders,
 
   const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
 
-  report("mixed_stream", iters * 5, (t1 - t0));
-  check_allocs("mixed_stream", new_before, new_after);
+  report(name, iters * 5, (t1 - t0));
+  check_allocs(name, new_before, new_after);
+}
+
+static void bench_mixed_stream(std::size_t max_orders,
+                               std::size_t warmup_iters,
+                               std::size_t iters,
+                               OrderId start_id,
+                               const char* name = "mixed_stream",
+                               BookConfig cfg = {},
+                               void (*setup)(Book&) = nullptr) {
+  Book book(max_orders, cfg);
+  if (setup) setup(book);
+  run_mixed_stream(book, warmup_iters, iters, start_id, name);
+}
+
+// The same stream on a runtime-sized Book and on a FixedBook of the same
+// capacity and price range. The Book has everything FixedBook lacks turned
+// off (sessions, risk, publishing, level updates, queue index; FIFO, and no
+// stops are ever added), so the gap is storage and constant bounds plus the
+// branches Book still takes to find those features off. Both are built
+// before either runs. The stream never reuses ids, so capacity has to cover
+// every id it issues.
+static void bench_fixed_vs_runtime(std::size_t warmup_iters, std::size_t iters) {
+  constexpr std::size_t capacity = 1u << 20;
+  constexpr PriceTicks max_price = 20'000;
+  if ((warmup_iters + iters) * 4 > capacity) {
+    std::cerr << "mixed_stream_fixed ERROR: stream needs more than " << capacity << " ids\n";
+    return;
+  }
+
+  BookConfig cfg;
+  cfg.ladder = {.min_price_ticks = 0, .max_price_ticks = max_price};
+  cfg.match_policy = MatchPolicy::Fifo;
+  cfg.max_sessions = 0;
+  cfg.max_order_id = capacity;
+  cfg.publish_depth = 0;
+  cfg.level_updates = false;
+  cfg.queue_position_levels = 0;
+  cfg.max_accounts = 0;
+  Book runtime(capacity, cfg);
+  // Around 100 MB of inline storage: too big for the stack. The constructor
+  // writes every node, so its pages are touched up front as Book's are.
+  static FixedBook<capacity, 0, max_price> fixed;
+
+  run_mixed_stream(runtime, warmup_iters, iters, 1, "mixed_stream_runtime");
+  run_mixed_stream(fixed, warmup_iters, iters, 1, "mixed_stream_fixed");
+  if (runtime.last_trade_price() != fixed.last_trade_price()) {
+    std::cerr << "mixed_stream_fixed ERROR: last trade differs from Book\n";
+  }
+}
+
+// Not a timing: each pre-trade limit must stop a stop order both when it is
+// entered and, after the limit is tightened, when it triggers. Prints an
+// ERROR line for any case that gets through. Account 1 (session 1) is the one
+// under test; account 0 provides the liquidity and the trigger trade.
+static void check_stop_risk() {
+  struct Recorder final : Book::EventSink {
+    std::vector<OrderId> done;
+    std::vector<OrderId> traded;
+    void on_done(const Book::DoneEvent& e) override { done.push_back(e.order_id); }
+    void on_trade(const Book::TradeEvent& e) override { traded.push_back(e.incoming_id); }
+  };
+
+  auto expect = [](bool ok, const char* what) {
+    if (!ok) std::cerr << "stop_risk ERROR: " << what << "\n";
+  };
+
+  auto make_book = [](const RiskLimits& limits) {
+    BookConfig cfg;
+    cfg.max_accounts = 2;
+    Book book(64, cfg);
+    const bool ok = book.set_session_account(1, 1) && book.set_risk_limits(1, limits);
+    do_not_optimize(ok);
+    return book;
+  };
+
+  // Entry: each limit rejects the stop outright.
+  auto rejected = [&](const RiskLimits& limits, OrderKind kind, Qty qty, PriceTicks limit_price,
+                      std::string_view reason, const char* what) {
+    Book book = make_book(limits);
+    const auto res = kind == OrderKind::Stop ? book.add_stop(1, qty, Side::Buy, 100, 1)
+                                             : book.add_stop_limit(1, qty, Side::Buy, 100, limit_price, 1);
+    expect(!res.accepted && res.reject_reason == reason, what);
+  };
+  rejected({.max_order_qty = 10}, OrderKind::Stop, 11, 0, "risk: max order qty", "max order qty not checked on entry");
+  rejected({.price_band = 5}, OrderKind::StopLimit, 1, 106, "risk: price band", "price band not checked on entry");
+  rejected({.max_open_notional = 500}, OrderKind::StopLimit, 10, 100, "risk: open notional",
+           "open notional not checked on entry");
+  rejected({.max_position = 5}, OrderKind::Stop, 6, 0, "risk: position", "position not checked on entry");
+
+  // Trigger: accepted under loose limits, then tightened so the release
+  // check fails; the stop must be dropped with on_done before it trades.
+  auto dropped = [&](const RiskLimits& loose, const RiskLimits& tight, OrderKind kind, Qty qty,
+                     PriceTicks limit_price, const char* what) {
+    Book book = make_book(loose);
+    Recorder rec;
+    book.set_sink(&rec);
+    const bool setup = book.add_limit(10, 1, Side::Sell, 100).accepted
+                    && book.add_limit(11, 50, Side::Sell, 101).accepted
+                    && (kind == OrderKind::Stop ? book.add_stop(1, qty, Side::Buy, 100, 1)
+                                                : book.add_stop_limit(1, qty, Side::Buy, 100, limit_price, 1)).accepted
+                    && book.set_risk_limits(1, tight)
+                    && book.add_limit(12, 1, Side::Buy, 100).accepted;
+    const bool ok = setup && rec.done == std::vector<OrderId>{1}
+                 && std::find(rec.traded.begin(), rec.traded.end(), OrderId{1}) == rec.traded.end()
+                 && !book.queue_position(1) && book.sweep_cost(Side::Buy, 50).filled == 50;
+    expect(ok, what);
+  };
+  dropped({.max_order_qty = 10}, {.max_order_qty = 1}, OrderKind::Stop, 2, 0, "max order qty not checked on trigger");
+  dropped({.price_band = 5}, {.price_band = 1}, OrderKind::StopLimit, 2, 103, "price band not checked on trigger");
+  dropped({.max_open_notional = 1'000}, {.max_open_notional = 100}, OrderKind::StopLimit, 2, 101,
+          "open notional not checked on trigger");
+  dropped({.max_position = 10}, {.max_position = 1}, OrderKind::Stop, 2, 0, "position not checked on trigger");
+
+  // A session remapped while its order rests: the order's notional must
+  // come off the account it was entered under.
+  {
+    Book book = make_book({});
+    const bool ok = book.add_limit(1, 2, Side::Buy, 50, 1).accepted
+                 && book.set_session_account(1, 0)
+                 && book.cancel(1);
+    expect(ok && book.risk_state(1).open_notional == 0 && book.risk_state(0).open_notional == 0,
+           "session remap moved open notional to the wrong account");
+  }
+}
+
+static void bench_stop_cascade(std::size_t max_orders,
+                               std::size_t warmup_rounds,
+                               std::size_t rounds,
+                               int depth) {
+  Book book(max_orders);
+  OrderId id = 1;
+
+  // Each round re-arms a ladder of bids with a sell stop at every bid price,
+  // then one aggressive sell sets off a cascade that walks the whole ladder.
+  auto setup = [&]() {
+    const auto r1 = book.add_limit(id++, 1, Side::Sell, 20000);
+    const auto r2 = book.add_limit(id++, 1, Side::Buy, 20000);
+    do_not_optimize(r1.accepted);
+    do_not_optimize(r2.accepted);
+    for (int i = depth - 1; i >= 0; --i) {
+      const auto res = book.add_limit(id++, 1, Side::Buy, 10000 - i);
+      do_not_optimize(res.accepted);
+    }
+    for (int i = depth - 1; i >= 0; --i) {
+      const auto res = book.add_stop(id++, 1, Side::Sell, 10000 - i);
+      do_not_optimize(res.accepted);
+    }
+  };
+
+  for (std::size_t i = 0; i < warmup_rounds; ++i) {
+    setup();
+    const auto res = book.add_limit(id++, 1, Side::Sell, 10000);
+    do_not_optimize(res.accepted);
+  }
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::uint64_t total_ns = 0;
+  for (std::size_t i = 0; i < rounds; ++i) {
+    setup();
+    const std::uint64_t t0 = ns_now();
+    const auto res = book.add_limit(id++, 1, Side::Sell, 10000);
+    const std::uint64_t t1 = ns_now();
+    do_not_optimize(res.accepted);
+    total_ns += t1 - t0;
+  }
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("stop_cascade", rounds * static_cast<std::size_t>(depth), total_ns);
+  check_allocs("stop_cascade", new_before, new_after);
+}
+
+// Starts with a pool a twentieth of the resting orders it ends up holding and
+// keeps a spare segment ready, from a housekeeping thread when there is a
+// spare core and otherwise from a housekeeping call between batches. Only the
+// add_limit batches are timed, and they must never allocate.
+static void bench_pool_growth(std::size_t initial_capacity,
+                              std::size_t segment_size,
+                              std::size_t ops) {
+  BookConfig cfg;
+  cfg.max_order_id = ops;
+  cfg.pool_segment_size = segment_size;
+  cfg.pool_low_water = segment_size;
+  Book book(initial_capacity, cfg);
+
+  const bool threaded = std::thread::hardware_concurrency() > 1;
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> refills{0};
+  std::thread housekeeping;
+  if (threaded) {
+    housekeeping = std::thread([&] {
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (book.refill_pool()) refills.fetch_add(1, std::memory_order_relaxed);
+        else std::this_thread::yield();
+      }
+    });
+  }
+
+  constexpr std::size_t BATCH = 4096;
+  std::uint32_t rng = 3;
+  std::size_t rejected = 0;
+  std::uint64_t total_ns = 0;
+  std::uint64_t batch_allocs = 0;
+
+  for (std::size_t i = 0; i < ops;) {
+    const std::size_t end = (ops - i < BATCH) ? ops : i + BATCH;
+    const std::uint64_t new_before = t_new_calls;
+    const std::uint64_t t0 = ns_now();
+    for (; i < end; ++i) {
+      const std::uint32_t r = lcg(rng);
+      const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+      const PriceTicks price = static_cast<PriceTicks>(side == Side::Buy ? 10000 - (r % 100) : 10001 + (r % 100));
+      const auto res = book.add_limit(static_cast<OrderId>(i + 1), 1, side, price);
+      if (!res.accepted) ++rejected;
+    }
+    const std::uint64_t t1 = ns_now();
+    total_ns += t1 - t0;
+    batch_allocs += t_new_calls - new_before;
+
+    if (!threaded && book.refill_pool()) refills.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  stop.store(true, std::memory_order_relaxed);
+  if (housekeeping.joinable()) housekeeping.join();
+
+  report("pool_growth", ops, total_ns);
+  std::cout << "pool_growth capacity=" << book.pool_capacity()
+            << " refills=" << refills.load(std::memory_order_relaxed)
+            << " rejected=" << rejected
+            << " housekeeping=" << (threaded ? "thread" : "inline") << "\n";
+  check_allocs("pool_growth", 0, batch_allocs);
+}
+
+// Matching throughput with depth publishing on and `readers` threads polling
+// snapshot() as fast as they can.
+static void bench_snapshot_readers(const char* name,
+                                   std::size_t publish_depth,
+                                   int readers,
+                                   std::size_t max_orders,
+                                   std::size_t iters,
+                                   bool batched = false) {
+  BookConfig cfg;
+  cfg.publish_depth = publish_depth;
+  cfg.publish_each_call = !batched;
+  Book book(max_orders, cfg);
+
+  std::atomic<bool> stop{false};
+  std::atomic<std::uint64_t> reads{0};
+  std::vector<std::thread> threads;
+  threads.reserve(static_cast<std::size_t>(readers));
+  for (int r = 0; r < readers; ++r) {
+    threads.emplace_back([&] {
+      std::uint64_t n = 0;
+      Qty seen = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        const BookSnapshot snap = book.snapshot();
+        seen += snap.bid_depth ? snap.bids[0].qty : 0;
+        ++n;
+      }
+      do_not_optimize(seen);
+      reads.fetch_add(n, std::memory_order_relaxed);
+    });
+  }
+
+  std::uint32_t rng = 42;
+  OrderId id = 1;
+  std::vector<OrderId> cancellable;
+  cancellable.reserve(iters * 3);
+
+  const std::uint64_t new_before = t_new_calls;
+
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t i = 0; i < iters; ++i) {
+    for (int k = 0; k < 3; ++k) {
+      const std::uint32_t r = lcg(rng);
+      const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+      const PriceTicks price = static_cast<PriceTicks>(10000 + (r % 20));
+      const auto res = book.add_limit(id, static_cast<Qty>(1 + (r % 5)), side, price);
+      do_not_optimize(res.accepted);
+      cancellable.push_back(id++);
+    }
+    const bool ok = book.cancel(cancellable.back());
+    cancellable.pop_back();
+    do_not_optimize(ok);
+
+    const std::uint32_t r2 = lcg(rng);
+    const Side aggressive_side = (r2 & 1u) ? Side::Buy : Side::Sell;
+    const auto res2 = book.add_limit(id++, 1, aggressive_side, aggressive_side == Side::Buy ? 20000 : 1);
+    do_not_optimize(res2.accepted);
+
+    if (batched) book.publish();
+  }
+  const std::uint64_t t1 = ns_now();
+
+  const std::uint64_t new_after = t_new_calls;
+  stop.store(true, std::memory_order_relaxed);
+  for (auto& t : threads) t.join();
+
+  report(name, iters * 5, (t1 - t0));
+  std::cout << name << " reader_snapshots=" << reads.load(std::memory_order_relaxed) << "\n";
+  check_allocs(name, new_before, new_after);
+}
+
+// Quote-stuffing shape: 20 adds near the touch per round, 20 cancels from
+// random queue positions and one marketable order, so ~95% of orders are
+// cancelled before they trade while about 4k stay resting.
+static void bench_cancel_heavy(const char* name, bool lazy, std::size_t rounds) {
+  BookConfig cfg;
+  cfg.lazy_cancel = lazy;
+  Book book(1'000'000, cfg);
+
+  std::uint32_t rng = 17;
+  OrderId id = 1;
+  std::vector<OrderId> live;
+  live.reserve(1'000'000);
+
+  auto add_quote = [&] {
+    const std::uint32_t r = lcg(rng);
+    const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+    const PriceTicks price = side == Side::Buy ? static_cast<PriceTicks>(10000 - (r >> 8) % 5)
+                                               : static_cast<PriceTicks>(10001 + (r >> 8) % 5);
+    const auto res = book.add_limit(id, 1 + static_cast<Qty>((r >> 16) % 5), side, price);
+    do_not_optimize(res.accepted);
+    live.push_back(id++);
+  };
+
+  for (std::size_t i = 0; i < 4'000; ++i) add_quote();
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::size_t ops = 0;
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t round = 0; round < rounds; ++round) {
+    for (int k = 0; k < 20; ++k) add_quote();
+    for (int k = 0; k < 20; ++k) {
+      const std::size_t at = lcg(rng) % live.size();
+      const bool ok = book.cancel(live[at]);
+      do_not_optimize(ok);
+      live[at] = live.back();
+      live.pop_back();
+    }
+    const std::uint32_t r = lcg(rng);
+    const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+    const auto res = book.add_limit(id++, 1, side, side == Side::Buy ? 20000 : 1);
+    do_not_optimize(res.accepted);
+    ops += 41;
+  }
+  const std::uint64_t t1 = ns_now();
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report(name, ops, t1 - t0);
+  check_allocs(name, new_before, new_after);
+}
+
+// Copy of a book with `resting` orders spread over 1000 levels a side, the
+// what-if path for callers that simulate on a scratch book. Reported per
+// copy, which includes building the empty ladder, id map and pool; the copy is
+// checked against the source after each round.
+static void bench_book_copy(std::size_t resting, std::size_t rounds) {
+  Book book(resting * 2);
+
+  std::uint32_t rng = 23;
+  for (OrderId id = 1; id <= resting; ++id) {
+    const std::uint32_t r = lcg(rng);
+    const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+    const PriceTicks price = side == Side::Buy ? static_cast<PriceTicks>(10000 - (r >> 8) % 1000)
+                                               : static_cast<PriceTicks>(10001 + (r >> 8) % 1000);
+    const auto res = book.add_limit(id, 1 + static_cast<Qty>((r >> 16) % 10), side, price, 1 + (r >> 4) % 16);
+    do_not_optimize(res.accepted);
+  }
+
+  std::uint64_t ns = 0;
+  for (std::size_t round = 0; round < rounds; ++round) {
+    const std::uint64_t t0 = ns_now();
+    Book copy(book);
+    ns += ns_now() - t0;
+
+    const auto a = book.sweep_cost(Side::Buy, static_cast<Qty>(resting));
+    const auto b = copy.sweep_cost(Side::Buy, static_cast<Qty>(resting));
+    if (copy.state_hash() != book.state_hash() || a.filled != b.filled || a.notional != b.notional) {
+      std::cerr << "book_copy ERROR: copy differs from source\n";
+      return;
+    }
+  }
+
+  report("book_copy", rounds, ns);
+}
+
+// One deep level with a third of it cancelled, then queue_position() for random
+// live orders: walking from the head (levels == 0) versus the Fenwick index.
+// `slots` below `depth` makes the block grow while the level fills.
+static void bench_queue_position(const char* name,
+                                 std::size_t levels,
+                                 std::size_t depth,
+                                 std::size_t queries,
+                                 std::uint32_t slots = 0) {
+  BookConfig cfg;
+  cfg.queue_position_levels = levels;
+  cfg.queue_position_slots = slots != 0 ? slots : static_cast<std::uint32_t>(depth);
+  Book book(depth, cfg);
+
+  std::uint32_t rng = 5;
+  for (std::size_t i = 1; i <= depth; ++i) {
+    const auto res = book.add_limit(static_cast<OrderId>(i), 1 + static_cast<Qty>(lcg(rng) % 5), Side::Buy, 10000);
+    do_not_optimize(res.accepted);
+  }
+
+  std::vector<OrderId> live;
+  live.reserve(depth);
+  for (std::size_t i = 1; i <= depth; ++i) {
+    if (lcg(rng) % 3 == 0) {
+      const bool ok = book.cancel(static_cast<OrderId>(i));
+      do_not_optimize(ok);
+    } else {
+      live.push_back(static_cast<OrderId>(i));
+    }
+  }
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  Qty sink = 0;
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t q = 0; q < queries; ++q) {
+    const auto pos = book.queue_position(live[lcg(rng) % live.size()]);
+    sink += pos->qty_ahead;
+  }
+  const std::uint64_t t1 = ns_now();
+  do_not_optimize(sink);
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report(name, queries, t1 - t0);
+  check_allocs(name, new_before, new_after);
+}
+
+// Not a timing: a level far deeper than queue_position_slots must keep its
+// block (growing it) and answer exactly what a walk of the queue gives.
+// Prints an ERROR line on the first mismatch.
+static void check_queue_position_deep(bool lazy) {
+  BookConfig indexed;
+  indexed.queue_position_levels = 4;
+  indexed.queue_position_slots = 16;
+  indexed.lazy_cancel = lazy;
+  BookConfig walked = indexed;
+  walked.queue_position_levels = 0;
+
+  constexpr std::size_t depth = 2'000;
+  Book a(depth * 2, indexed);
+  Book b(depth * 2, walked);
+
+  std::uint32_t rng = 13;
+  auto add = [&](OrderId id, Qty qty, Side side) {
+    const auto ra = a.add_limit(id, qty, side, 10000);
+    const auto rb = b.add_limit(id, qty, side, 10000);
+    do_not_optimize(ra.accepted && rb.accepted);
+  };
+  auto cancel = [&](OrderId id) {
+    const bool ca = a.cancel(id);
+    const bool cb = b.cancel(id);
+    do_not_optimize(ca == cb);
+  };
+
+  OrderId taker = 1'000'000;
+  for (OrderId id = 1; id <= depth; ++id) {
+    add(id, 1 + static_cast<Qty>(lcg(rng) % 5), Side::Buy);
+    if (lcg(rng) % 4 == 0) cancel(1 + lcg(rng) % id);
+    if (id % 256 == 0) add(taker++, 1 + static_cast<Qty>(lcg(rng) % 40), Side::Sell);
+  }
+
+  for (OrderId id = 1; id <= depth; ++id) {
+    const auto pa = a.queue_position(id);
+    const auto pb = b.queue_position(id);
+    if (pa.has_value() != pb.has_value() ||
+        (pa && (pa->qty_ahead != pb->qty_ahead || pa->rank != pb->rank))) {
+      std::cerr << (lazy ? "queue_position_deep_lazy" : "queue_position_deep")
+                << " ERROR: order " << id << " differs from a walk\n";
+      return;
+    }
+  }
+}
+
+// Router-style sizing: 16 sizes from one lot to most of the side, asked of a
+// book with `levels` levels of a few orders each, one size at a time or all
+// at once. ops counts sizes answered.
+static void bench_sweep_cost(const char* name, bool batched, std::size_t levels, std::size_t rounds) {
+  Book book(levels * 8);
+
+  std::uint32_t rng = 11;
+  OrderId id = 1;
+  for (std::size_t l = 0; l < levels; ++l) {
+    for (int k = 0; k < 4; ++k) {
+      const auto res = book.add_limit(id++, 1 + static_cast<Qty>(lcg(rng) % 20), Side::Sell,
+                                      static_cast<PriceTicks>(10001 + l));
+      do_not_optimize(res.accepted);
+    }
+  }
+
+  constexpr std::size_t sizes = 16;
+  Qty qtys[sizes];
+  for (std::size_t j = 0; j < sizes; ++j) qtys[j] = static_cast<Qty>(1 + (j * j * levels * 40) / (sizes * sizes));
+  SweepCost out[sizes];
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  Qty sink = 0;
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t r = 0; r < rounds; ++r) {
+    if (batched) {
+      book.sweep_cost(Side::Buy, qtys, out);
+    } else {
+      for (std::size_t j = 0; j < sizes; ++j) out[j] = book.sweep_cost(Side::Buy, qtys[j]);
+    }
+    sink += out[r % sizes].notional;
+  }
+  const std::uint64_t t1 = ns_now();
+  do_not_optimize(sink);
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report(name, rounds * sizes, t1 - t0);
+  check_allocs(name, new_before, new_after);
+}
+
+struct CountingSink final : Book::EventSink {
+  std::uint64_t cancels = 0;
+  void on_ack_cancel(const Book::AckCancelEvent&) override { ++cancels; }
+  void on_mass_cancel(const Book::MassCancelEvent& e) override { cancels += e.order_ids.size(); }
+};
+
+enum class KillSwitch { PerId, BySession, BySide };
+
+// Time to pull every one of `resting` orders spread over 64 sessions and
+// 2 x 500 levels, per-id versus through the bulk calls.
+static void bench_kill_switch(const char* name,
+                              KillSwitch mode,
+                              std::size_t max_orders,
+                              std::size_t resting,
+                              std::size_t rounds) {
+  Book book(max_orders);
+  CountingSink sink;
+  book.set_sink(&sink);
+  std::uint32_t rng = 5;
+  constexpr SessionId SESSIONS = 64;
+
+  // The per-id loop cancels in the order a gateway would hold its open
+  // orders, not in pool-node order.
+  std::vector<OrderId> ids(resting);
+  for (std::size_t i = 0; i < resting; ++i) ids[i] = static_cast<OrderId>(i + 1);
+  for (std::size_t i = resting; i > 1; --i) std::swap(ids[i - 1], ids[lcg(rng) % i]);
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::uint64_t total_ns = 0;
+  for (std::size_t r = 0; r < rounds; ++r) {
+    for (std::size_t i = 0; i < resting; ++i) {
+      const std::uint32_t x = lcg(rng);
+      const Side side = (i & 1u) ? Side::Buy : Side::Sell;
+      const PriceTicks price = static_cast<PriceTicks>(side == Side::Buy ? 10000 - (x % 500) : 10001 + (x % 500));
+      const SessionId session = 1 + static_cast<SessionId>(x % SESSIONS);
+      const auto res = book.add_limit(static_cast<OrderId>(i + 1), 1, side, price, session);
+      do_not_optimize(res.accepted);
+    }
+
+    const std::uint64_t t0 = ns_now();
+    switch (mode) {
+      case KillSwitch::PerId:
+        for (const OrderId id : ids) {
+          const bool ok = book.cancel(id);
+          do_not_optimize(ok);
+        }
+        break;
+      case KillSwitch::BySession:
+        for (SessionId s = 1; s <= SESSIONS; ++s) {
+          const std::size_t n = book.cancel_session(s);
+          do_not_optimize(n);
+        }
+        break;
+      case KillSwitch::BySide: {
+        const std::size_t n = book.cancel_side(Side::Buy) + book.cancel_side(Side::Sell);
+        do_not_optimize(n);
+        break;
+      }
+    }
+    const std::uint64_t t1 = ns_now();
+    total_ns += t1 - t0;
+  }
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report(name, resting * rounds, total_ns);
+  std::cout << name << " us_per_kill_switch=" << double(total_ns) / double(rounds) / 1e3 << "\n";
+  check_allocs(name, new_before, new_after);
+  if (sink.cancels != resting * rounds) {
+    std::cerr << name << " ERROR: cancelled " << sink.cancels << " of " << resting * rounds << "\n";
+  }
 }
 
 int main() {
@@ -252,7 +927,64 @@ int main() {
   bench_add_resting(MAX_ORDERS, WARMUP, OPS, 1);
   bench_cancel(MAX_ORDERS, WARMUP / 10, OPS / 2, 1);
   bench_marketable_match(MAX_ORDERS, WARMUP, OPS, 1);
+  {
+    // Same run with a do-nothing sink, then with trade analytics inline: the
+    // first difference is the per-trade virtual call, the second the
+    // statistics themselves (VWAP and histogram, then with both bar series).
+    Book::EventSink null_sink;
+    bench_marketable_match(MAX_ORDERS, WARMUP, OPS, 1, "marketable_match_null_sink", &null_sink);
+
+    TradeAnalytics analytics;
+    AnalyticsSink sink(analytics);
+    bench_marketable_match(MAX_ORDERS, WARMUP, OPS, 1, "marketable_match_analytics", &sink, &sink);
+
+    TradeAnalytics with_bars({.ladder = {}, .bar_interval_ns = 1'000'000, .bar_volume = 1'000});
+    AnalyticsSink bars_sink(with_bars);
+    bench_marketable_match(MAX_ORDERS, WARMUP, OPS, 1, "marketable_match_analytics_bars", &bars_sink, &bars_sink);
+  }
+  bench_pro_rata_match(MAX_ORDERS, WARMUP / 10, OPS / 10, 1);
+  bench_iceberg_refill(MAX_ORDERS, WARMUP, OPS, 1);
   bench_mixed_stream(MAX_ORDERS, 50'000, 500'000, 1);
+  {
+    BookConfig cfg;
+    cfg.queue_position_levels = 64;
+    bench_mixed_stream(MAX_ORDERS, 50'000, 500'000, 1, "mixed_stream_queue_position", cfg);
+  }
+  {
+    // Every limit is checked and none binds, so nothing is rejected: this is
+    // the pure cost of the checks and counter updates.
+    BookConfig cfg;
+    cfg.max_accounts = 64;
+    bench_mixed_stream(MAX_ORDERS, 50'000, 500'000, 1, "mixed_stream_risk", cfg, [](Book& book) {
+      const bool ok = book.set_risk_limits(0, {.max_order_qty = 1'000,
+                                               .max_open_notional = std::int64_t{1} << 60,
+                                               .max_position = std::int64_t{1} << 40,
+                                               .price_band = 20'000});
+      do_not_optimize(ok);
+    });
+  }
+  bench_fixed_vs_runtime(20'000, 200'000);
+  check_stop_risk();
+  bench_stop_cascade(MAX_ORDERS, 20, 200, 1000);
+  bench_pool_growth(100'000, 100'000, OPS);
+  bench_snapshot_readers("snapshot_off", 0, 0, MAX_ORDERS, 500'000);
+  bench_snapshot_readers("snapshot_readers_0", 5, 0, MAX_ORDERS, 500'000);
+  bench_snapshot_readers("snapshot_readers_1", 5, 1, MAX_ORDERS, 500'000);
+  bench_snapshot_readers("snapshot_readers_4", 5, 4, MAX_ORDERS, 500'000);
+  bench_snapshot_readers("snapshot_batched", 5, 0, MAX_ORDERS, 500'000, true);
+  bench_cancel_heavy("cancel_heavy_eager", false, 100'000);
+  bench_cancel_heavy("cancel_heavy_lazy", true, 100'000);
+  bench_book_copy(100'000, 10);
+  bench_sweep_cost("sweep_cost_single", false, 64, 100'000);
+  bench_sweep_cost("sweep_cost_batched", true, 64, 100'000);
+  bench_queue_position("queue_position_walk", 0, 10'000, 20'000);
+  bench_queue_position("queue_position_index", 1, 10'000, 2'000'000);
+  bench_queue_position("queue_position_grown", 1, 10'000, 2'000'000, 64);
+  check_queue_position_deep(false);
+  check_queue_position_deep(true);
+  bench_kill_switch("kill_switch_per_id", KillSwitch::PerId, 100'000, 100'000, 20);
+  bench_kill_switch("kill_switch_session", KillSwitch::BySession, 100'000, 100'000, 20);
+  bench_kill_switch("kill_switch_side", KillSwitch::BySide, 100'000, 100'000, 20);
 
   std::cout << "process_total_new_calls="
             << g_new_calls.load(std::memory_order_relaxed)
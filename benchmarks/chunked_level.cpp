@@ -0,0 +1,118 @@
+#include "chunked_level.hpp"
+
+#include <cassert>
+#include <cstddef>
+
+namespace clob {
+
+QueueChunkPool::QueueChunkPool(std::size_t capacity)
+  : storage_(capacity)
+{
+  for (auto& chunk : storage_) {
+    chunk.next = free_head_;
+    free_head_ = &chunk;
+    ++free_count_;
+  }
+
+  assert(free_count_ == storage_.size());
+}
+
+QueueChunk* QueueChunkPool::allocate() noexcept
+{
+  if (free_head_ == nullptr) {
+    return static_cast<QueueChunk*>(nullptr);
+  }
+
+  QueueChunk* chunk = free_head_;
+  free_head_ = chunk->next;
+
+  chunk->next = nullptr;
+  chunk->begin = 0;
+  chunk->end = 0;
+
+  assert(free_count_ > 0);
+  --free_count_;
+
+  return chunk;
+}
+
+void QueueChunkPool::free(QueueChunk* chunk) noexcept
+{
+  if (chunk == nullptr) {
+    return;
+  }
+
+  chunk->next = free_head_;
+  free_head_ = chunk;
+  ++free_count_;
+}
+
+bool ChunkedLevel::push_back(QueueChunkPool& pool, OrderId order_id, Qty qty, QueueSlotRef& out) noexcept
+{
+  assert(qty > 0);
+
+  if (!tail || tail->end == QueueChunk::slots_per_chunk) {
+    QueueChunk* chunk = pool.allocate();
+    if (!chunk) return false;
+
+    if (tail) {
+      tail->next = chunk;
+    } else {
+      head = chunk;
+    }
+    tail = chunk;
+  }
+
+  const std::uint16_t index = tail->end++;
+  tail->slots[index] = QueueSlot{order_id, qty};
+  ++live;
+
+  out = QueueSlotRef{tail, index};
+  return true;
+}
+
+QueueSlot* ChunkedLevel::front(QueueChunkPool& pool) noexcept
+{
+  while (head) {
+    while (head->begin < head->end) {
+      QueueSlot& slot = head->slots[head->begin];
+      if (slot.qty != 0) return &slot;
+      ++head->begin;
+      --tombstones;
+    }
+
+    if (head == tail) {
+      head->begin = 0;
+      head->end = 0;
+      return static_cast<QueueSlot*>(nullptr);
+    }
+
+    QueueChunk* done = head;
+    head = head->next;
+    pool.free(done);
+  }
+
+  return static_cast<QueueSlot*>(nullptr);
+}
+
+void ChunkedLevel::pop_front() noexcept
+{
+  assert(head && head->begin < head->end);
+  assert(live > 0);
+
+  head->slots[head->begin].qty = 0;
+  ++head->begin;
+  --live;
+}
+
+void ChunkedLevel::erase(QueueSlotRef ref) noexcept
+{
+  assert(ref.chunk && ref.index < ref.chunk->end);
+  assert(ref.chunk->slots[ref.index].qty != 0);
+
+  ref.chunk->slots[ref.index].qty = 0;
+  --live;
+  ++tombstones;
+}
+
+} // namespace clob
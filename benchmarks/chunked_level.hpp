@@ -0,0 +1,123 @@
+#pragma once
+
+#include "clob/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clob {
+
+// Alternative price-level queue: an unrolled list of fixed-size chunks whose
+// slots hold the order id and remaining qty inline, so sweeping the touch reads
+// memory sequentially instead of chasing one pool node per order. Cancels
+// leave a tombstone (qty == 0) that is skipped at the front and squeezed out
+// by compact().
+
+struct QueueSlot {
+  OrderId order_id{};
+  Qty     qty{};
+};
+
+struct QueueChunk {
+  static constexpr std::uint16_t slots_per_chunk = 31;
+
+  QueueChunk* next{nullptr};
+  std::uint16_t begin{0};
+  std::uint16_t end{0};
+
+  QueueSlot slots[slots_per_chunk];
+};
+
+struct QueueSlotRef {
+  QueueChunk* chunk{nullptr};
+  std::uint16_t index{0};
+};
+
+class QueueChunkPool {
+public:
+  explicit QueueChunkPool(std::size_t capacity);
+
+  QueueChunk* allocate() noexcept;
+  void free(QueueChunk* chunk) noexcept;
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return storage_.size(); }
+  [[nodiscard]] std::size_t free_count() const noexcept { return free_count_; }
+
+private:
+  std::vector<QueueChunk> storage_;
+  QueueChunk* free_head_{nullptr};
+
+  std::size_t free_count_{0};
+};
+
+struct ChunkedLevel {
+  PriceTicks price_ticks{};
+
+  QueueChunk* head{nullptr};
+  QueueChunk* tail{nullptr};
+
+  std::size_t live{0};
+  std::size_t tombstones{0};
+
+  bool push_back(QueueChunkPool& pool, OrderId order_id, Qty qty, QueueSlotRef& out) noexcept;
+  QueueSlot* front(QueueChunkPool& pool) noexcept;
+  void pop_front() noexcept;
+  void erase(QueueSlotRef ref) noexcept;
+
+  [[nodiscard]] auto empty() const noexcept { return live == 0; }
+  [[nodiscard]] auto needs_compaction() const noexcept {
+    return tombstones >= QueueChunk::slots_per_chunk && tombstones > live;
+  }
+
+  // Slides live slots down over the tombstones and releases the chunks left
+  // empty. relocate(order_id, QueueSlotRef) is called for every slot that
+  // moves so the caller can repoint its id -> slot mapping.
+  template <class Relocate>
+  void compact(QueueChunkPool& pool, Relocate&& relocate) noexcept;
+};
+
+template <class Relocate>
+void ChunkedLevel::compact(QueueChunkPool& pool, Relocate&& relocate) noexcept
+{
+  if (!head) return;
+
+  QueueChunk* wchunk = head;
+  std::uint16_t widx = 0;
+
+  for (QueueChunk* rchunk = head; rchunk; rchunk = rchunk->next) {
+    for (std::uint16_t ridx = rchunk->begin; ridx < rchunk->end; ++ridx) {
+      const QueueSlot slot = rchunk->slots[ridx];
+      if (slot.qty == 0) continue;
+
+      if (widx == QueueChunk::slots_per_chunk) {
+        wchunk->end = widx;
+        wchunk = wchunk->next;
+        wchunk->begin = 0;
+        widx = 0;
+      }
+
+      if (wchunk != rchunk || widx != ridx) {
+        wchunk->slots[widx] = slot;
+        relocate(slot.order_id, QueueSlotRef{wchunk, widx});
+      }
+      ++widx;
+    }
+  }
+
+  head->begin = 0;
+  wchunk->end = widx;
+
+  QueueChunk* spare = wchunk->next;
+  wchunk->next = nullptr;
+  tail = wchunk;
+  while (spare) {
+    QueueChunk* next = spare->next;
+    pool.free(spare);
+    spare = next;
+  }
+
+  tombstones = 0;
+}
+
+} // namespace clob
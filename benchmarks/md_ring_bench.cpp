@@ -0,0 +1,301 @@
+#include "clob/analytics_replay.hpp"
+#include "clob/book.hpp"
+#include "clob/md_ring.hpp"
+#include "clob/md_sink.hpp"
+#include "clob/types.hpp"
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace clob;
+
+static inline std::uint64_t ns_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static inline std::uint32_t lcg(std::uint32_t& s) {
+  s = 1664525u * s + 1013904223u;
+  return s;
+}
+
+static void report(const char* name, std::size_t ops, std::uint64_t ns) {
+  const double sec = double(ns) * 1e-9;
+  const double ops_per_s = sec > 0.0 ? (double(ops) / sec) : 0.0;
+  const double ns_per_op = ops ? (double(ns) / double(ops)) : 0.0;
+  std::cout << name
+            << " ops=" << ops
+            << " sec=" << sec
+            << " ns_per_op=" << ns_per_op
+            << " ops_per_s=" << ops_per_s
+            << "\n";
+}
+
+static constexpr OrderId end_marker = ~OrderId{0};
+static constexpr std::size_t ops_per_iter = 5;
+
+// Same shape as book_bench's mixed_stream: three resting adds, one cancel, one
+// marketable order.
+struct MixedStream {
+  std::uint32_t rng = 42;
+  OrderId id = 1;
+  std::vector<OrderId> cancellable;
+
+  explicit MixedStream(std::size_t iters) { cancellable.reserve(iters * 3); }
+
+  void step(Book& book) {
+    for (int k = 0; k < 3; ++k) {
+      const std::uint32_t r = lcg(rng);
+      const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+      const PriceTicks price = static_cast<PriceTicks>(10000 + (r % 20));
+      const Qty qty = static_cast<Qty>(1 + (r % 5));
+      (void)book.add_limit(id, qty, side, price);
+      cancellable.push_back(id++);
+    }
+
+    const OrderId victim = cancellable.back();
+    cancellable.pop_back();
+    (void)book.cancel(victim);
+
+    const std::uint32_t r2 = lcg(rng);
+    const Side aggressive_side = (r2 & 1u) ? Side::Buy : Side::Sell;
+    const PriceTicks aggressive_price = aggressive_side == Side::Buy ? 20000 : 1;
+    (void)book.add_limit(id++, 1, aggressive_side, aggressive_price);
+  }
+};
+
+// Matching-thread cost of the sink alone: nobody reads the ring.
+static void bench_sink_overhead(const char* name, bool use_ring, bool stamp, std::size_t iters) {
+  MdRingWriter ring;
+  if (use_ring) {
+    const auto res = ring.create("clob_md_bench_overhead", 1u << 16);
+    if (!res.ok) {
+      std::cerr << name << " ERROR: " << *res.error << "\n";
+      return;
+    }
+  }
+
+  Book::EventSink null_sink;
+  MdRingSink ring_sink(ring, stamp);
+
+  BookConfig cfg;
+  cfg.level_updates = use_ring;
+  Book book(iters * 4 + 16, cfg);
+  book.set_sink(use_ring ? static_cast<Book::EventSink*>(&ring_sink) : &null_sink);
+
+  MixedStream stream(iters);
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t i = 0; i < iters; ++i) stream.step(book);
+  const std::uint64_t t1 = ns_now();
+
+  report(name, iters * ops_per_iter, t1 - t0);
+  if (use_ring) std::cout << name << " records=" << ring.cursor() << "\n";
+}
+
+// Child side: follow the ring until the end marker and report one-way latency
+// from the writer's stamp to the moment the record is read.
+[[noreturn]] static void run_reader(const char* ring_name, int ready_fd, bool yield_when_idle) {
+  MdRingReader reader;
+  const auto res = reader.open(ring_name);
+  const char ok = res.ok ? 1 : 0;
+  (void)!::write(ready_fd, &ok, 1);
+  ::close(ready_fd);
+  if (!res.ok) {
+    std::cerr << "md_ring_latency ERROR: " << *res.error << "\n";
+    ::_exit(1);
+  }
+
+  std::vector<std::uint64_t> latencies;
+  latencies.reserve(1u << 24);
+  std::uint64_t overruns = 0;
+
+  MdRecord rec;
+  for (;;) {
+    const MdReadStatus st = reader.try_read(rec);
+    if (st == MdReadStatus::Ok) {
+      if (rec.type == MdRecordType::Heartbeat && rec.order_id == end_marker) break;
+      if (rec.ts_ns != 0 && latencies.size() < latencies.capacity()) {
+        latencies.push_back(md_now_ns() - rec.ts_ns);
+      }
+    } else if (st == MdReadStatus::Overrun) {
+      ++overruns;
+    } else if (yield_when_idle) {
+      ::sched_yield();
+    }
+  }
+
+  std::sort(latencies.begin(), latencies.end());
+  auto pct = [&](double p) {
+    if (latencies.empty()) return std::uint64_t{0};
+    return latencies[static_cast<std::size_t>(p * double(latencies.size() - 1))];
+  };
+
+  std::cout << "md_ring_latency records=" << latencies.size()
+            << " p50_ns=" << pct(0.50)
+            << " p99_ns=" << pct(0.99)
+            << " p999_ns=" << pct(0.999)
+            << " max_ns=" << (latencies.empty() ? 0 : latencies.back())
+            << " overruns=" << overruns
+            << " lost=" << reader.lost()
+            << "\n";
+  std::cout.flush();
+  ::_exit(0);
+}
+
+// Writer and reader in separate processes on one ring. The writer is paced at
+// one mixed-stream iteration per gap_ns so the numbers are queueing-free
+// latency rather than backlog.
+static void bench_two_process(std::size_t iters, std::uint64_t gap_ns) {
+  const std::string ring_name = "clob_md_bench_" + std::to_string(::getpid());
+
+  MdRingWriter ring;
+  const auto res = ring.create(ring_name, 1u << 16);
+  if (!res.ok) {
+    std::cerr << "md_ring_latency ERROR: " << *res.error << "\n";
+    return;
+  }
+
+  // With one core the two processes share it; idle spinning on either side
+  // would only burn the other's time slice.
+  const bool single_core = std::thread::hardware_concurrency() <= 1;
+
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    std::cerr << "md_ring_latency ERROR: pipe failed\n";
+    return;
+  }
+
+  std::cout.flush();
+  const pid_t child = ::fork();
+  if (child < 0) {
+    std::cerr << "md_ring_latency ERROR: fork failed\n";
+    return;
+  }
+  if (child == 0) {
+    ::close(fds[0]);
+    run_reader(ring_name.c_str(), fds[1], single_core);
+  }
+
+  ::close(fds[1]);
+  char ready = 0;
+  const bool reader_ok = ::read(fds[0], &ready, 1) == 1 && ready == 1;
+  ::close(fds[0]);
+
+  if (reader_ok) {
+    MdRingSink sink(ring, true);
+    BookConfig cfg;
+    cfg.level_updates = true;
+    Book book(iters * 4 + 16, cfg);
+    book.set_sink(&sink);
+
+    MixedStream stream(iters);
+    std::uint64_t next = md_now_ns();
+    for (std::size_t i = 0; i < iters; ++i) {
+      stream.step(book);
+      next += gap_ns;
+      while (md_now_ns() < next) {
+        if (single_core) ::sched_yield();
+      }
+    }
+  }
+
+  // Keep repeating the end marker: a reader that was overrun may have jumped
+  // past an earlier copy.
+  int status = 0;
+  while (::waitpid(child, &status, WNOHANG) == 0) {
+    ring.push(MdRecord{.order_id = end_marker, .type = MdRecordType::Heartbeat});
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+  }
+}
+
+static bool same_bars(const BarSeries& a, const BarSeries& b) {
+  if (a.closed() != b.closed() || a.size() != b.size()) return false;
+  auto same = [](const Bar& x, const Bar& y) {
+    return x.start_ns == y.start_ns && x.last_ns == y.last_ns && x.open == y.open && x.high == y.high
+        && x.low == y.low && x.close == y.close && x.volume == y.volume && x.notional == y.notional
+        && x.trades == y.trades;
+  };
+  for (std::size_t i = 0; i < a.size(); ++i) {
+    if (!same(a[i], b[i])) return false;
+  }
+  return same(a.current(), b.current());
+}
+
+// Recorded per-instrument trade streams (with some non-trade records mixed
+// in, as a market-data capture would have) replayed one instrument after the
+// other on this thread, then with a thread per instrument.
+static void bench_analytics_replay(std::size_t instruments, std::size_t trades_per_instrument) {
+  const AnalyticsConfig cfg{.ladder = {.min_price_ticks = 9'000, .max_price_ticks = 11'000},
+                            .bar_interval_ns = 1'000'000,
+                            .bar_volume = 5'000};
+
+  std::vector<std::vector<MdRecord>> streams(instruments);
+  for (std::size_t k = 0; k < instruments; ++k) {
+    std::uint32_t rng = 42 + static_cast<std::uint32_t>(k);
+    std::uint64_t ts = 0;
+    PriceTicks price = 10'000;
+    auto& records = streams[k];
+    records.reserve(trades_per_instrument * 5 / 4 + 1);
+    for (std::size_t i = 0; i < trades_per_instrument; ++i) {
+      const std::uint32_t r = lcg(rng);
+      ts += 1 + (r >> 8) % 2'000;
+      if ((r & 3u) == 0) records.push_back({.ts_ns = ts, .order_id = static_cast<OrderId>(i), .type = MdRecordType::AckAdd});
+      price += static_cast<PriceTicks>((r >> 4) % 3) - 1;
+      if (price < 9'500) price = 9'500;
+      if (price > 10'500) price = 10'500;
+      records.push_back({.ts_ns = ts, .qty = static_cast<Qty>(1 + (r >> 12) % 10), .price_ticks = price,
+                         .type = MdRecordType::Trade});
+    }
+  }
+
+  std::vector<TradeAnalytics> sequential(instruments, TradeAnalytics(cfg));
+  std::vector<TradeAnalytics> parallel(instruments, TradeAnalytics(cfg));
+  std::vector<AnalyticsJob> jobs;
+  for (std::size_t k = 0; k < instruments; ++k) jobs.push_back({.records = streams[k], .analytics = &parallel[k]});
+
+  const std::uint64_t t0 = ns_now();
+  for (std::size_t k = 0; k < instruments; ++k) replay(sequential[k], streams[k]);
+  const std::uint64_t t1 = ns_now();
+
+  const std::uint64_t t2 = ns_now();
+  replay_parallel(jobs);
+  const std::uint64_t t3 = ns_now();
+
+  const std::size_t trades = instruments * trades_per_instrument;
+  report("analytics_replay_sequential", trades, t1 - t0);
+  report("analytics_replay_parallel", trades, t3 - t2);
+
+  for (std::size_t k = 0; k < instruments; ++k) {
+    const TradeAnalytics& a = sequential[k];
+    const TradeAnalytics& b = parallel[k];
+    const bool same = a.trades() == trades_per_instrument && a.trades() == b.trades() && a.volume() == b.volume()
+                   && a.notional() == b.notional() && a.last_price() == b.last_price()
+                   && std::ranges::equal(a.volume_at_price(), b.volume_at_price())
+                   && same_bars(a.time_bars(), b.time_bars()) && same_bars(a.volume_bars(), b.volume_bars());
+    if (!same) std::cerr << "analytics_replay_parallel ERROR: instrument " << k << " differs from sequential\n";
+  }
+}
+
+int main() {
+  constexpr std::size_t ITERS = 500'000;
+
+  bench_sink_overhead("md_sink_none", false, false, ITERS);
+  bench_sink_overhead("md_sink_ring", true, false, ITERS);
+  bench_sink_overhead("md_sink_ring_stamped", true, true, ITERS);
+
+  bench_two_process(200'000, 2'000);
+  bench_analytics_replay(4, 500'000);
+  return 0;
+}
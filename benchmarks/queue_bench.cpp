@@ -0,0 +1,258 @@
+#include "chunked_level.hpp"
+
+#include "clob/order.hpp"
+#include "clob/price_level.hpp"
+#include "clob/types.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace clob;
+
+static inline std::uint64_t ns_now() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+static inline std::uint32_t lcg(std::uint32_t& s) {
+  s = 1664525u * s + 1013904223u;
+  return s;
+}
+
+template <class T>
+static inline void do_not_optimize(T const& value) {
+#if defined(__clang__) || defined(__GNUC__)
+  asm volatile("" : : "g"(value) : "memory");
+#else
+  (void)value;
+#endif
+}
+
+static std::atomic<std::uint64_t> g_new_calls{0};
+
+void* operator new(std::size_t n) {
+  g_new_calls.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n)) return p;
+  std::abort();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+
+void* operator new[](std::size_t n) {
+  g_new_calls.fetch_add(1, std::memory_order_relaxed);
+  if (void* p = std::malloc(n)) return p;
+  std::abort();
+}
+void operator delete[](void* p) noexcept { std::free(p); }
+
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+static void report(const char* name, std::size_t ops, std::uint64_t ns) {
+  const double sec = double(ns) * 1e-9;
+  const double ops_per_s = sec > 0.0 ? (double(ops) / sec) : 0.0;
+  const double ns_per_op = ops ? (double(ns) / double(ops)) : 0.0;
+  std::cout << name
+            << " ops=" << ops
+            << " sec=" << sec
+            << " ns_per_op=" << ns_per_op
+            << " ops_per_s=" << ops_per_s
+            << "\n";
+}
+
+static void check_allocs(const char* name, std::uint64_t before, std::uint64_t after) {
+  const std::uint64_t delta = after - before;
+  if (delta != 0) {
+    std::cerr << name << " ERROR: allocations during timed loop = " << delta << "\n";
+  }
+}
+
+// Pool nodes in a busy book are handed out in whatever order the free list
+// has them, so the linked queue is filled in shuffled node order.
+static void fill_linked(OrderPool& pool, PriceLevel& lvl, std::vector<Order*>& by_id,
+                        std::vector<Order*>& scratch, std::uint32_t& rng) {
+  const std::size_t depth = scratch.size();
+  for (std::size_t i = 0; i < depth; ++i) scratch[i] = pool.allocate();
+  for (std::size_t i = depth; i > 1; --i) {
+    std::swap(scratch[i - 1], scratch[lcg(rng) % i]);
+  }
+  for (std::size_t i = 0; i < depth; ++i) {
+    Order* o = scratch[i];
+    o->order_id = static_cast<OrderId>(i + 1);
+    o->qty_remaining = 1 + static_cast<Qty>(i % 3);
+    lvl.push_back(o);
+    by_id[i + 1] = o;
+  }
+}
+
+static void fill_chunked(QueueChunkPool& pool, ChunkedLevel& lvl, std::vector<QueueSlotRef>& refs,
+                         std::size_t depth) {
+  for (std::size_t i = 0; i < depth; ++i) {
+    const bool ok = lvl.push_back(pool, static_cast<OrderId>(i + 1), 1 + static_cast<Qty>(i % 3), refs[i + 1]);
+    do_not_optimize(ok);
+  }
+}
+
+static Qty sweep_linked(OrderPool& pool, PriceLevel& lvl, Qty incoming) {
+  while (incoming > 0 && !lvl.empty()) {
+    Order* rest = lvl.head;
+    const Qty t = incoming < rest->qty_remaining ? incoming : rest->qty_remaining;
+    incoming -= t;
+    rest->qty_remaining -= t;
+    if (rest->qty_remaining == 0) pool.free(lvl.pop_front());
+  }
+  return incoming;
+}
+
+static Qty sweep_chunked(QueueChunkPool& pool, ChunkedLevel& lvl, Qty incoming) {
+  while (incoming > 0) {
+    QueueSlot* rest = lvl.front(pool);
+    if (!rest) break;
+    const Qty t = incoming < rest->qty ? incoming : rest->qty;
+    incoming -= t;
+    rest->qty -= t;
+    if (rest->qty == 0) lvl.pop_front();
+  }
+  return incoming;
+}
+
+static void bench_deep_sweep_linked(std::size_t depth, std::size_t rounds) {
+  OrderPool pool(depth);
+  PriceLevel lvl;
+  std::vector<Order*> by_id(depth + 1, nullptr);
+  std::vector<Order*> scratch(depth, nullptr);
+  std::uint32_t rng = 7;
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::uint64_t total_ns = 0;
+  for (std::size_t r = 0; r < rounds; ++r) {
+    fill_linked(pool, lvl, by_id, scratch, rng);
+    const std::uint64_t t0 = ns_now();
+    const Qty left = sweep_linked(pool, lvl, static_cast<Qty>(depth) * 3);
+    const std::uint64_t t1 = ns_now();
+    do_not_optimize(left);
+    total_ns += t1 - t0;
+  }
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("deep_sweep_linked", depth * rounds, total_ns);
+  check_allocs("deep_sweep_linked", new_before, new_after);
+}
+
+static void bench_deep_sweep_chunked(std::size_t depth, std::size_t rounds) {
+  QueueChunkPool pool(depth / QueueChunk::slots_per_chunk + 2);
+  ChunkedLevel lvl;
+  std::vector<QueueSlotRef> refs(depth + 1);
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::uint64_t total_ns = 0;
+  for (std::size_t r = 0; r < rounds; ++r) {
+    fill_chunked(pool, lvl, refs, depth);
+    const std::uint64_t t0 = ns_now();
+    const Qty left = sweep_chunked(pool, lvl, static_cast<Qty>(depth) * 3);
+    const std::uint64_t t1 = ns_now();
+    do_not_optimize(left);
+    total_ns += t1 - t0;
+  }
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("deep_sweep_chunked", depth * rounds, total_ns);
+  check_allocs("deep_sweep_chunked", new_before, new_after);
+}
+
+// Cancels a random half of the queue (anywhere in it), then sweeps the rest.
+static void bench_cancel_middle_linked(std::size_t depth, std::size_t rounds) {
+  OrderPool pool(depth);
+  PriceLevel lvl;
+  std::vector<Order*> by_id(depth + 1, nullptr);
+  std::vector<Order*> scratch(depth, nullptr);
+  std::vector<OrderId> victims(depth / 2);
+  std::uint32_t rng = 11;
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::uint64_t total_ns = 0;
+  for (std::size_t r = 0; r < rounds; ++r) {
+    fill_linked(pool, lvl, by_id, scratch, rng);
+    for (std::size_t i = 0; i < victims.size(); ++i) {
+      victims[i] = static_cast<OrderId>(2 * i + 1 + (lcg(rng) & 1u));
+    }
+
+    const std::uint64_t t0 = ns_now();
+    for (const OrderId id : victims) {
+      Order* o = by_id[id];
+      lvl.erase(o);
+      pool.free(o);
+    }
+    const Qty left = sweep_linked(pool, lvl, static_cast<Qty>(depth) * 3);
+    const std::uint64_t t1 = ns_now();
+    do_not_optimize(left);
+    total_ns += t1 - t0;
+  }
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("cancel_middle_linked", depth * rounds, total_ns);
+  check_allocs("cancel_middle_linked", new_before, new_after);
+}
+
+static void bench_cancel_middle_chunked(std::size_t depth, std::size_t rounds) {
+  QueueChunkPool pool(depth / QueueChunk::slots_per_chunk + 2);
+  ChunkedLevel lvl;
+  std::vector<QueueSlotRef> refs(depth + 1);
+  std::vector<OrderId> victims(depth / 2);
+  std::uint32_t rng = 11;
+
+  auto relocate = [&](OrderId id, QueueSlotRef ref) { refs[id] = ref; };
+
+  const std::uint64_t new_before = g_new_calls.load(std::memory_order_relaxed);
+
+  std::uint64_t total_ns = 0;
+  for (std::size_t r = 0; r < rounds; ++r) {
+    fill_chunked(pool, lvl, refs, depth);
+    for (std::size_t i = 0; i < victims.size(); ++i) {
+      victims[i] = static_cast<OrderId>(2 * i + 1 + (lcg(rng) & 1u));
+    }
+
+    const std::uint64_t t0 = ns_now();
+    for (const OrderId id : victims) {
+      lvl.erase(refs[id]);
+      if (lvl.needs_compaction()) lvl.compact(pool, relocate);
+    }
+    const Qty left = sweep_chunked(pool, lvl, static_cast<Qty>(depth) * 3);
+    const std::uint64_t t1 = ns_now();
+    do_not_optimize(left);
+    total_ns += t1 - t0;
+  }
+
+  const std::uint64_t new_after = g_new_calls.load(std::memory_order_relaxed);
+
+  report("cancel_middle_chunked", depth * rounds, total_ns);
+  check_allocs("cancel_middle_chunked", new_before, new_after);
+}
+
+int main() {
+  constexpr std::size_t DEPTH = 200'000;
+  constexpr std::size_t ROUNDS = 20;
+
+  bench_deep_sweep_linked(DEPTH, ROUNDS);
+  bench_deep_sweep_chunked(DEPTH, ROUNDS);
+  bench_cancel_middle_linked(DEPTH, ROUNDS);
+  bench_cancel_middle_chunked(DEPTH, ROUNDS);
+
+  std::cout << "process_total_new_calls="
+            << g_new_calls.load(std::memory_order_relaxed)
+            << "\n";
+  return 0;
+}
@@ -0,0 +1,292 @@
+#include "clob/book.hpp"
+#include "clob/replication.hpp"
+#include "clob/types.hpp"
+
+#include <sched.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace clob;
+
+static inline std::uint32_t lcg(std::uint32_t& s) {
+  s = 1664525u * s + 1013904223u;
+  return s;
+}
+
+static constexpr std::size_t ops_per_iter = 5;
+static constexpr std::size_t max_orders = 2'000'000;
+
+struct Percentiles {
+  std::vector<std::uint64_t> v;
+
+  void print(const char* name) {
+    std::sort(v.begin(), v.end());
+    auto pct = [&](double p) {
+      if (v.empty()) return std::uint64_t{0};
+      return v[static_cast<std::size_t>(p * double(v.size() - 1))];
+    };
+    std::cout << name
+              << " p50_ns=" << pct(0.50)
+              << " p99_ns=" << pct(0.99)
+              << " p999_ns=" << pct(0.999)
+              << " max_ns=" << (v.empty() ? 0 : v.back())
+              << "\n";
+  }
+};
+
+// Same shape as book_bench's mixed_stream: three resting adds, one cancel, one
+// marketable order. Each add_limit call is timed on its own.
+struct MixedStream {
+  std::uint32_t rng = 42;
+  OrderId id = 1;
+  std::vector<OrderId> cancellable;
+  Percentiles add_latency;
+
+  explicit MixedStream(std::size_t iters) {
+    cancellable.reserve(iters * 3);
+    add_latency.v.reserve(iters * 4);
+  }
+
+  template <typename B>
+  void add(B& book, Qty qty, Side side, PriceTicks price) {
+    const std::uint64_t t0 = repl_now_ns();
+    (void)book.add_limit(id++, qty, side, price);
+    add_latency.v.push_back(repl_now_ns() - t0);
+  }
+
+  template <typename B>
+  void step(B& book) {
+    for (int k = 0; k < 3; ++k) {
+      const std::uint32_t r = lcg(rng);
+      const Side side = (r & 1u) ? Side::Buy : Side::Sell;
+      cancellable.push_back(id);
+      add(book, static_cast<Qty>(1 + (r % 5)), side, static_cast<PriceTicks>(10000 + (r % 20)));
+    }
+
+    const OrderId victim = cancellable.back();
+    cancellable.pop_back();
+    (void)book.cancel(victim);
+
+    const std::uint32_t r2 = lcg(rng);
+    const Side aggressive_side = (r2 & 1u) ? Side::Buy : Side::Sell;
+    add(book, 1, aggressive_side, aggressive_side == Side::Buy ? 20000 : 1);
+  }
+};
+
+template <typename B>
+static void run_primary(const char* name, B& book, Book& local, std::size_t iters) {
+  MixedStream stream(iters);
+  const std::uint64_t t0 = repl_now_ns();
+  for (std::size_t i = 0; i < iters; ++i) stream.step(book);
+  const std::uint64_t t1 = repl_now_ns();
+
+  const std::size_t ops = iters * ops_per_iter;
+  std::cout << name
+            << " ops=" << ops
+            << " sec=" << double(t1 - t0) * 1e-9
+            << " ns_per_op=" << double(t1 - t0) / double(ops)
+            << " state_hash=" << local.state_hash()
+            << "\n";
+  stream.add_latency.print((std::string(name) + "_add_limit").c_str());
+}
+
+// Child side: apply until every command of the run is in, recording how long
+// each one took from the primary's stamp to being applied here.
+[[noreturn]] static void run_replica(const char* ring_name, int ready_fd, std::uint64_t expected, bool yield_when_idle) {
+  Book book(max_orders);
+  Replica replica(book);
+  const auto res = replica.open(ring_name);
+  const char ok = res.ok ? 1 : 0;
+  (void)!::write(ready_fd, &ok, 1);
+  ::close(ready_fd);
+  if (!res.ok) {
+    std::cerr << "repl_lag ERROR: " << *res.error << "\n";
+    ::_exit(1);
+  }
+
+  Percentiles lag;
+  lag.v.reserve(expected);
+
+  while (replica.applied() < expected) {
+    if (replica.poll(1) == 0) {
+      if (yield_when_idle) ::sched_yield();
+      continue;
+    }
+    lag.v.push_back(repl_now_ns() - replica.last_ts_ns());
+  }
+
+  lag.print("repl_lag");
+  std::cout << "repl_replica applied=" << replica.applied()
+            << " diverged=" << (replica.diverged_at() ? "yes" : "no")
+            << " state_hash=" << book.state_hash()
+            << "\n";
+  std::cout.flush();
+  ::_exit(0);
+}
+
+// Primary and replica in separate processes on one ring.
+static void bench_live(std::size_t iters) {
+  const std::string ring_name = "clob_repl_bench_" + std::to_string(::getpid());
+
+  ReplWriter writer;
+  const auto res = writer.create(ring_name, 1u << 16);
+  if (!res.ok) {
+    std::cerr << "repl_on ERROR: " << *res.error << "\n";
+    return;
+  }
+
+  // With one core the two processes share it; idle spinning on the replica
+  // would only burn the primary's time slice.
+  const bool single_core = std::thread::hardware_concurrency() <= 1;
+
+  int fds[2];
+  if (::pipe(fds) != 0) {
+    std::cerr << "repl_on ERROR: pipe failed\n";
+    return;
+  }
+
+  std::cout.flush();
+  const pid_t child = ::fork();
+  if (child < 0) {
+    std::cerr << "repl_on ERROR: fork failed\n";
+    return;
+  }
+  if (child == 0) {
+    ::close(fds[0]);
+    run_replica(ring_name.c_str(), fds[1], iters * ops_per_iter, single_core);
+  }
+
+  ::close(fds[1]);
+  char ready = 0;
+  const bool replica_ok = ::read(fds[0], &ready, 1) == 1 && ready == 1;
+  ::close(fds[0]);
+
+  if (replica_ok) {
+    Book book(max_orders);
+    ReplicatedBook primary(book, writer, true);
+    run_primary("repl_on", primary, book, iters);
+  }
+
+  int status = 0;
+  ::waitpid(child, &status, 0);
+}
+
+// Failover: the primary runs with nobody applying, then a fresh replica
+// catches up on the whole backlog.
+static void bench_drain(std::size_t iters) {
+  const std::string ring_name = "clob_repl_drain_" + std::to_string(::getpid());
+
+  ReplWriter writer;
+  const auto res = writer.create(ring_name, iters * ops_per_iter);
+  if (!res.ok) {
+    std::cerr << "repl_drain ERROR: " << *res.error << "\n";
+    return;
+  }
+
+  Book book(max_orders);
+  ReplicatedBook primary(book, writer);
+  MixedStream stream(iters);
+  for (std::size_t i = 0; i < iters; ++i) stream.step(primary);
+
+  Book standby(max_orders);
+  Replica replica(standby);
+  if (!replica.open(ring_name).ok) {
+    std::cerr << "repl_drain ERROR: open failed\n";
+    return;
+  }
+
+  const std::uint64_t t0 = repl_now_ns();
+  const std::size_t n = replica.drain();
+  const std::uint64_t t1 = repl_now_ns();
+
+  std::cout << "repl_drain commands=" << n
+            << " sec=" << double(t1 - t0) * 1e-9
+            << " ns_per_command=" << (n ? double(t1 - t0) / double(n) : 0.0)
+            << " in_sync=" << (standby.state_hash() == book.state_hash() && !replica.diverged_at() ? "yes" : "no")
+            << "\n";
+}
+
+// Failover with risk on. Limits, the session mapping and pool refills go
+// through ReplicatedBook like any other command, so the standby rejects the
+// same orders, tracks the same exposure and grows its pool at the same points.
+// Limits are tightened halfway through the stream.
+static void bench_drain_risk(std::size_t iters) {
+  const std::string ring_name = "clob_repl_drain_risk_" + std::to_string(::getpid());
+
+  ReplWriter writer;
+  const auto res = writer.create(ring_name, iters * ops_per_iter + 64);
+  if (!res.ok) {
+    std::cerr << "repl_drain_risk ERROR: " << *res.error << "\n";
+    return;
+  }
+
+  BookConfig cfg;
+  cfg.max_accounts = 4;
+  cfg.max_order_id = max_orders;
+  cfg.pool_segment_size = 1024;
+  cfg.pool_low_water = 256;
+
+  struct RejectCounter final : Book::EventSink {
+    std::size_t rejects{0};
+    void on_reject_add(const Book::RejectAddEvent&) override { ++rejects; }
+  } counter;
+
+  Book book(1024, cfg);
+  book.set_sink(&counter);
+  ReplicatedBook primary(book, writer);
+  (void)primary.set_session_account(0, 1);
+  (void)primary.set_risk_limits(1, {.max_order_qty = 4, .max_open_notional = 2'000'000'000,
+                                    .max_position = 1'000, .price_band = 20'000});
+
+  MixedStream stream(iters);
+  for (std::size_t i = 0; i < iters; ++i) {
+    if (i == iters / 2) {
+      (void)primary.set_risk_limits(1, {.max_order_qty = 3, .max_open_notional = 2'000'000'000,
+                                        .max_position = 200, .price_band = 20'000});
+    }
+    if (book.pool_needs_refill()) (void)primary.refill_pool();
+    stream.step(primary);
+  }
+
+  Book standby(1024, cfg);
+  Replica replica(standby);
+  if (!replica.open(ring_name).ok) {
+    std::cerr << "repl_drain_risk ERROR: open failed\n";
+    return;
+  }
+  const std::size_t n = replica.drain();
+
+  const RiskState a = book.risk_state(1);
+  const RiskState b = standby.risk_state(1);
+  const bool in_sync = standby.state_hash() == book.state_hash() && !replica.diverged_at() &&
+                       a.open_notional == b.open_notional && a.position == b.position &&
+                       standby.pool_capacity() == book.pool_capacity();
+  std::cout << "repl_drain_risk commands=" << n
+            << " rejects=" << counter.rejects
+            << " pool_capacity=" << book.pool_capacity()
+            << " in_sync=" << (in_sync ? "yes" : "no")
+            << "\n";
+  if (!in_sync) std::cerr << "repl_drain_risk ERROR: standby diverged from the primary\n";
+  if (counter.rejects == 0) std::cerr << "repl_drain_risk ERROR: limits never bound\n";
+}
+
+int main() {
+  constexpr std::size_t ITERS = 400'000;
+
+  {
+    Book book(max_orders);
+    run_primary("repl_off", book, book, ITERS);
+  }
+  bench_live(ITERS);
+  bench_drain(50'000);
+  bench_drain_risk(50'000);
+  return 0;
+}
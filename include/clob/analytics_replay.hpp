@@ -0,0 +1,28 @@
+#pragma once
+
+#include "clob/md_ring.hpp"
+#include "clob/trade_analytics.hpp"
+
+#include <span>
+
+namespace clob {
+
+// Batch mode for TradeAnalytics over recorded market data. Part of clob_md,
+// next to the record format, so the core library does not depend on the ring.
+
+// Feeds every Trade record of a recorded stream (e.g. captured from an
+// MdRingReader) through on_trade with its ts_ns; other records are skipped.
+void replay(TradeAnalytics& analytics, std::span<const MdRecord> records) noexcept;
+
+// One instrument's recorded stream and the analytics it feeds.
+struct AnalyticsJob {
+  std::span<const MdRecord> records;
+  TradeAnalytics* analytics;
+};
+
+// Replays every job on a thread of its own and returns once all have
+// finished. Each job must have its own TradeAnalytics; the results are the
+// same as feeding the trades to on_trade one by one.
+void replay_parallel(std::span<const AnalyticsJob> jobs);
+
+} // namespace clob
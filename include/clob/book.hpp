@@ -1,17 +1,118 @@
+#pragma once
+
 #include "clob/ladder.hpp"
 #include "clob/order.hpp"
 #include "clob/price_level.hpp"
+#include "clob/queue_position.hpp"
+#include "clob/risk.hpp"
+#include "clob/seqlock.hpp"
 
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
 #include <vector>
 
 namespace clob {
 
+// How an incoming order's quantity is split across the queue at each crossed
+// price level.
+enum class MatchPolicy : std::uint8_t {
+  Fifo,            // price-time: oldest order first
+  ProRata,         // in proportion to displayed size, rounding down; residue FIFO
+  TopOrderProRata  // head of the queue filled first, then pro-rata on the rest
+};
+
+struct DepthLevel {
+  PriceTicks price_ticks{};
+  Qty qty{};
+};
+
+// Top-of-book and top-N depth as last published by Book. Level 0 of each side
+// is the best price; only the first bid_depth / ask_depth entries are valid.
+struct BookSnapshot {
+  static constexpr std::size_t max_depth = 8;
+
+  std::uint64_t sequence{};
+  std::uint32_t bid_depth{};
+  std::uint32_t ask_depth{};
+  PriceTicks last_trade_price{};
+  std::uint32_t has_last_trade{};
+
+  DepthLevel bids[max_depth]{};
+  DepthLevel asks[max_depth]{};
+};
+
+struct BookConfig {
+  LadderConfig ladder{};
+  MatchPolicy match_policy{MatchPolicy::Fifo};
+  // Pro-rata shares below this are dropped and go to the FIFO residue instead.
+  Qty pro_rata_min_qty{1};
+  // Session tags must be below this; 0 is the untagged session.
+  SessionId max_sessions{1024};
+  // Order ids must be in [1, max_order_id]; 0 means the same as max_orders.
+  std::size_t max_order_id{0};
+  // Pool growth: with a non-zero segment size the pool keeps one spare
+  // segment of that many nodes in reserve, and refill_pool() parks a new one
+  // once the free count is at or below pool_low_water.
+  std::size_t pool_segment_size{0};
+  std::size_t pool_low_water{0};
+  // Levels per side published to snapshot(); 0 turns publishing off. Capped
+  // at BookSnapshot::max_depth.
+  std::size_t publish_depth{0};
+  // Republish at the end of every call that changed the published levels.
+  // Off, nothing is published until the caller calls publish(), e.g. once
+  // per batch of input.
+  bool publish_each_call{true};
+  // Report aggregate level changes through EventSink::on_level_update.
+  bool level_updates{false};
+  // Queue-position tracking for queue_position(): up to this many levels at
+  // once, each starting with room for queue_position_slots arrivals and
+  // renumbered or doubled when full. 0 turns it off and queries walk the level
+  // instead; at most 65535 levels.
+  std::size_t queue_position_levels{0};
+  std::uint32_t queue_position_slots{1024};
+  // Pre-trade risk on every add, stops included, for accounts
+  // [0, max_accounts); 0 turns it off. Sessions map to account 0 until
+  // set_session_account.
+  std::size_t max_accounts{0};
+  // Lazy cancel: cancel() leaves the order in its queue as a zero-qty
+  // tombstone, reclaimed by matching, when the level drains, or once a level
+  // holds at least lazy_cancel_compact_at of them and as many as it had live
+  // orders at its last compaction.
+  bool lazy_cancel{false};
+  std::uint32_t lazy_cancel_compact_at{64};
+};
+
+struct QueuePosition {
+  Qty qty_ahead{};          // displayed qty of the orders in front
+  std::size_t rank{};       // orders in front; 0 at the head of the queue
+};
+
+// What sweeping one side of the book for a given qty would cost, from the
+// displayed per-level quantities.
+struct SweepCost {
+  Qty filled{};             // less than asked if the side ran out
+  Qty notional{};           // sum of price_ticks * qty over the fills
+  PriceTicks worst_price{}; // last level reached; 0 if nothing filled
+  std::size_t levels{};     // levels reached, the last one possibly in part
+
+  [[nodiscard]] double vwap() const noexcept { return filled ? double(notional) / double(filled) : 0.0; }
+};
+
 class Book {
 public:
-  explicit Book(std::size_t max_orders);
+  explicit Book(std::size_t max_orders, BookConfig cfg = {});
+
+  // Deep copy: same resting and pending orders, queue order and time
+  // priority, risk counters, state hash, last trade and published snapshot,
+  // in a pool of its own with the source's current capacity. The copy starts
+  // with no sink. Not safe against a concurrent refill_pool on the source.
+  Book(const Book& other);
+  Book& operator=(const Book&) = delete;
 
   struct AddResult {
     bool accepted;
@@ -24,6 +125,8 @@ public:
   struct RejectAddEvent { OrderId order_id; std::string_view reason; };
   struct AckCancelEvent { OrderId order_id; };
   struct RejectCancelEvent { OrderId order_id; std::string_view reason; };
+  struct MassCancelEvent { std::span<const OrderId> order_ids; };
+  struct LevelUpdateEvent { Side side; PriceTicks price; Qty qty; };
 
   struct EventSink {
     virtual ~EventSink() = default;
@@ -33,31 +136,178 @@ public:
     virtual void on_reject_cancel(const RejectCancelEvent&) {}
     virtual void on_trade(const TradeEvent&) {}
     virtual void on_done(const DoneEvent&) {} 
+    // Cancels from the mass-cancel calls arrive in batches; by default each
+    // one is forwarded to on_ack_cancel.
+    virtual void on_mass_cancel(const MassCancelEvent& e) {
+      for (OrderId order_id : e.order_ids) on_ack_cancel({order_id});
+    }
+    // New aggregate qty of a price level (0 once it is empty). Only sent with
+    // BookConfig::level_updates; a sweep reports each crossed level once.
+    virtual void on_level_update(const LevelUpdateEvent&) {}
   };
 
   void set_sink(EventSink* sink) noexcept { sink_ = sink; };
 
-  void match_buy (OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty);
-  void match_sell(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty);
-  
-  AddResult add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price);
+  AddResult add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price, SessionId session = 0);
+
+  AddResult add_iceberg(OrderId order_id, Qty qty, Side side, PriceTicks price, Qty display_qty,
+                        SessionId session = 0);
+
+  AddResult add_stop(OrderId order_id, Qty qty, Side side, PriceTicks stop_price, SessionId session = 0);
+  AddResult add_stop_limit(OrderId order_id, Qty qty, Side side, PriceTicks stop_price, PriceTicks limit_price,
+                           SessionId session = 0);
 
   bool cancel(OrderId order_id) noexcept;
 
+  // Bulk cancels; each returns the number of orders cancelled. cancel_side
+  // also drops that side's pending stops, cancel_price_range only touches
+  // resting orders with lo <= price <= hi.
+  std::size_t cancel_session(SessionId session) noexcept;
+  std::size_t cancel_side(Side side) noexcept;
+  std::size_t cancel_price_range(Side side, PriceTicks lo, PriceTicks hi) noexcept;
+
+  [[nodiscard]] std::optional<PriceTicks> last_trade_price() const noexcept { return last_trade_price_; }
+
+  // Order-independent hash of every resting order's id, side, price,
+  // remaining qty (displayed and reserve) and time priority; 0 for an empty
+  // book. Kept up to date on each change, so two books fed the same commands
+  // can be compared after every message. Pending stops are not included.
+  [[nodiscard]] std::uint64_t state_hash() const noexcept { return state_hash_; }
+
+  // Cost of an incoming order of `side` for qty (a buy walks the asks) without
+  // touching the book. Only displayed qty counts: iceberg reserve and any
+  // stops the sweep would trigger are not modelled.
+  [[nodiscard]] SweepCost sweep_cost(Side side, Qty qty) const noexcept;
+  // Same for every qty in qtys (any order) in one walk of the ladder; out
+  // must be at least as long as qtys.
+  void sweep_cost(Side side, std::span<const Qty> qtys, std::span<SweepCost> out) const noexcept;
+
+  // Where a resting order stands in its level's queue; nullopt for unknown
+  // ids and pending stops. O(log n) on levels with a queue-position block,
+  // otherwise a walk from the head.
+  [[nodiscard]] std::optional<QueuePosition> queue_position(OrderId order_id) const noexcept;
+
+  // Risk setup; both return false for ids out of range or with risk off. A
+  // remap applies to orders entered afterwards: live orders stay on the
+  // account they were entered under.
+  bool set_risk_limits(AccountId account, const RiskLimits& limits) noexcept { return risk_.set_limits(account, limits); }
+  bool set_session_account(SessionId session, AccountId account) noexcept {
+    return risk_.set_session_account(session, account);
+  }
+  [[nodiscard]] RiskState risk_state(AccountId account) const noexcept { return risk_.state(account); }
+
+  // Pool housekeeping. These two may run on another thread (one at a time)
+  // while the matching thread keeps trading; only refill_pool allocates.
+  [[nodiscard]] bool pool_needs_refill() const noexcept { return pool_.needs_refill(); }
+  bool refill_pool() { return pool_.refill(); }
+  [[nodiscard]] std::size_t pool_capacity() const noexcept { return pool_.capacity(); }
+
+  // Matching thread only: publishes the snapshot now if the published levels
+  // or last trade changed since the previous publish; a no-op otherwise.
+  void publish() noexcept;
+
+  // Safe from any thread: readers only load the seqlock-published snapshot.
+  // try_snapshot makes a single wait-free attempt and fails if it overlapped
+  // a publish; snapshot retries until it gets a consistent copy.
+  [[nodiscard]] BookSnapshot snapshot() const noexcept { return snapshot_.load(); }
+  [[nodiscard]] bool try_snapshot(BookSnapshot& out) const noexcept { return snapshot_.try_load(out); }
+
 private:
+  BookConfig cfg_;
   OrderPool pool_;
   OrderIdMap id_map_;
   Ladder ladder_;
 
+  // Pending stops, indexed by stop price. Buy stops fire when the last trade
+  // rises to their stop, so they sit on the ask chain (lowest first); sell
+  // stops fire on the way down and sit on the bid chain (highest first).
+  // Both ladders span the full price range, so they are only built on the
+  // first stop order; books that never see one pay nothing for them.
+  struct StopLadders {
+    Ladder buys;
+    Ladder sells;
+  };
+  std::unique_ptr<StopLadders> stops_;
+
   EventSink* sink_{nullptr};
 
   PriceLevel* bid_level_{nullptr};
   PriceLevel* ask_level_{nullptr};
 
   std::uint64_t next_time_seq_{1};
+  std::optional<PriceTicks> last_trade_price_;
+  std::uint64_t state_hash_{0};
+
+  std::vector<Order*> session_heads_;
+
+  static constexpr std::size_t mass_cancel_batch_size = 1024;
+  std::vector<OrderId> cancel_batch_;
+
+  QueuePositionIndex queue_index_;
+  RiskTable risk_;
+
+  // Lazy cancel, per ladder price: tombstones still queued on the level and
+  // its live count at the last compaction. Empty unless lazy_cancel is on.
+  struct TombstoneCount {
+    std::uint32_t tombstones{0};
+    std::uint32_t compact_at{0};
+  };
+  std::vector<TombstoneCount> tombstones_;
+
+  std::uint64_t publish_seq_{0};
+  // Set when a level at or inside the last published depth changes; the
+  // bounds are the deepest published prices, or open-ended while a side had
+  // fewer than publish_depth levels.
+  bool publish_dirty_{true};
+  PriceTicks publish_bid_floor_{std::numeric_limits<PriceTicks>::min()};
+  PriceTicks publish_ask_ceiling_{std::numeric_limits<PriceTicks>::max()};
+  Seqlock<BookSnapshot> snapshot_;
 
   [[nodiscard]] static auto is_valid_price(PriceTicks price) noexcept;
   void assign_time_seq(Order& order) noexcept;
+
+  template <Side S, MatchPolicy P>
+  void match(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty);
+  void match_buy (OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty);
+  void match_sell(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty);
+  void fill(PriceLevel& lvl, Order& rest, OrderId incoming_id, Qty qty);
+  void fill_fifo(PriceLevel& lvl, OrderId incoming_id, Qty& incoming_qty);
+  void fill_pro_rata(PriceLevel& lvl, OrderId incoming_id, Qty& incoming_qty);
+
+  AddResult add_stop_order(OrderId order_id, Qty qty, Side side, OrderKind kind,
+                           PriceTicks stop_price, PriceTicks limit_price, SessionId session);
+  AddResult add_order(OrderId order_id, Qty qty, Side side, PriceTicks price, Qty display_qty,
+                      SessionId session);
+  void rest_order(Order* order) noexcept;
+  void risk_remove(const Order& order) noexcept;
+  void release(Order& order) noexcept;
+  void copy_chain(const Ladder& from, Ladder& to, Side chain);
+  void link_session(Order& order) noexcept;
+  void unlink_session(Order& order) noexcept;
+  void unlink_from_book(Order& order) noexcept;
+  void tombstone(Order& order) noexcept;
+  void reap(PriceLevel& lvl, Order& order) noexcept;
+  void compact_level(PriceLevel& lvl) noexcept;
+  void reclaim_tombstones() noexcept;
+  void level_drained(PriceLevel& lvl, Side side) noexcept;
+  [[nodiscard]] TombstoneCount& tombstones_at(const PriceLevel& lvl) noexcept
+  {
+    return tombstones_[static_cast<std::size_t>(lvl.price_ticks - ladder_.min_price_ticks())];
+  }
+  std::size_t cancel_level(PriceLevel& lvl) noexcept;
+  void batch_cancel(OrderId order_id) noexcept;
+  void flush_cancel_batch() noexcept;
+  void auto_publish() noexcept { if (cfg_.publish_each_call) publish(); }
+  void level_update(Side side, const PriceLevel& lvl) noexcept;
+  void level_emptied(PriceLevel& lvl) noexcept;
+  void queue_track(PriceLevel& lvl, Order& order) noexcept;
+  void queue_untrack(PriceLevel& lvl) noexcept;
+  void queue_renumber(PriceLevel& lvl, const Order& last) noexcept;
+  void replenish(PriceLevel& lvl, Order& order) noexcept;
+  void unlink_stop(Order& order) noexcept;
+  [[nodiscard]] Order* next_triggered_stop() const noexcept;
+  void release_stop(Order* order);
+  void trigger_stops();
 };
 
 }
@@ -0,0 +1,216 @@
+#pragma once
+
+#include "clob/book.hpp"
+#include "clob/ladder.hpp"
+#include "clob/order.hpp"
+#include "clob/price_level.hpp"
+#include "clob/types.hpp"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+namespace clob {
+
+// A Book whose capacity and price grid are template parameters. Levels, order
+// nodes and the id map live inline in the object, so level and id lookups
+// index off `this` with constant bounds, strides and offsets instead of going
+// through vector data pointers and runtime sizes. The level chains are
+// Ladder's own (LevelChains); only the storage differs.
+//
+// Only the core path is covered: FIFO limit orders and cancels, reported
+// through the same EventSink and AddResult as Book and rejected with the same
+// reasons in the same order. No icebergs, stops, sessions, risk, queue
+// position, snapshots, state hash or lazy cancel; use Book for those.
+//
+// Ids run from 1 to MaxOrders and a price must lie on the grid
+// MinTick + k * TickWidth up to MaxTick ("invalid price" otherwise). The
+// object is as large as its storage, so large instances belong on the heap
+// (std::make_unique) rather than the stack.
+template <std::size_t MaxOrders, PriceTicks MinTick, PriceTicks MaxTick, PriceTicks TickWidth = 1>
+class FixedBook {
+  static_assert(MaxOrders > 0 && MaxOrders < std::numeric_limits<OrderId>::max());
+  static_assert(TickWidth > 0);
+  static_assert(MinTick <= MaxTick);
+  static_assert((std::int64_t{MaxTick} - MinTick) % TickWidth == 0, "MaxTick must be on the tick grid");
+
+public:
+  using AddResult = Book::AddResult;
+  using EventSink = Book::EventSink;
+
+  static constexpr std::size_t max_orders = MaxOrders;
+  static constexpr std::size_t level_count = static_cast<std::size_t>((std::int64_t{MaxTick} - MinTick) / TickWidth) + 1;
+
+  FixedBook() noexcept
+  {
+    for (std::size_t i = 0; i < level_count; ++i) {
+      levels_[i].price_ticks = static_cast<PriceTicks>(MinTick + static_cast<PriceTicks>(i) * TickWidth);
+    }
+  }
+
+  FixedBook(const FixedBook&) = delete;
+  FixedBook& operator=(const FixedBook&) = delete;
+
+  void set_sink(EventSink* sink) noexcept { sink_ = sink; }
+
+  AddResult add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price) noexcept;
+  bool cancel(OrderId order_id) noexcept;
+
+  [[nodiscard]] static constexpr bool is_valid_price(PriceTicks p) noexcept
+  {
+    return MinTick <= p && p <= MaxTick && (TickWidth == 1 || (std::int64_t{p} - MinTick) % TickWidth == 0);
+  }
+
+  [[nodiscard]] std::optional<PriceTicks> last_trade_price() const noexcept { return last_trade_price_; }
+  [[nodiscard]] const PriceLevel* best_bid_level() const noexcept { return chains_.best_bid; }
+  [[nodiscard]] const PriceLevel* best_ask_level() const noexcept { return chains_.best_ask; }
+
+  [[nodiscard]] const PriceLevel& level_at(PriceTicks p) const noexcept
+  {
+    assert(is_valid_price(p));
+    return levels_[index_of(p)];
+  }
+
+private:
+  std::array<PriceLevel, level_count> levels_{};
+  std::array<Order*, MaxOrders + 1> by_id_{};
+  std::array<Order, MaxOrders> nodes_{};
+
+  Order* free_head_{nullptr};
+  std::size_t bump_{0};
+
+  LevelChains chains_;
+
+  EventSink* sink_{nullptr};
+  std::uint64_t next_time_seq_{1};
+  std::optional<PriceTicks> last_trade_price_;
+
+  [[nodiscard]] static constexpr std::size_t index_of(PriceTicks p) noexcept
+  {
+    return static_cast<std::size_t>(std::int64_t{p} - MinTick) / static_cast<std::size_t>(TickWidth);
+  }
+
+  AddResult reject(OrderId order_id, std::string_view reason) noexcept
+  {
+    if (sink_) sink_->on_reject_add({order_id, reason});
+    return {.accepted = false, .reject_reason = reason};
+  }
+
+  template <Side S>
+  void match(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty) noexcept;
+
+  // Every live order holds a distinct id no larger than MaxOrders, so the
+  // node array can never run out.
+  Order* allocate() noexcept
+  {
+    Order* node = free_head_;
+    if (node != nullptr) {
+      free_head_ = node->next;
+      node->next = nullptr;
+    } else {
+      assert(bump_ < MaxOrders);
+      node = &nodes_[bump_++];
+    }
+    return node;
+  }
+
+  void release(Order& order) noexcept
+  {
+    by_id_[order.order_id] = nullptr;
+    order.next = free_head_;
+    free_head_ = &order;
+  }
+};
+
+template <std::size_t N, PriceTicks Lo, PriceTicks Hi, PriceTicks W>
+typename FixedBook<N, Lo, Hi, W>::AddResult
+FixedBook<N, Lo, Hi, W>::add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price) noexcept
+{
+  if (qty <= 0) return reject(order_id, "qty <= 0");
+  if (!is_valid_price(price)) return reject(order_id, "invalid price");
+  if (order_id == 0 || order_id > N) return reject(order_id, "invalid order_id");
+  if (by_id_[order_id] != nullptr) return reject(order_id, "duplicate order_id");
+
+  Qty incoming_qty = qty;
+  if (side == Side::Buy) match<Side::Buy>(order_id, price, incoming_qty);
+  else                   match<Side::Sell>(order_id, price, incoming_qty);
+
+  if (incoming_qty == 0) return {.accepted = true, .reject_reason = {}};
+
+  Order* inc = allocate();
+  inc->order_id = order_id;
+  inc->side = side;
+  inc->price_ticks = price;
+  inc->qty_remaining = incoming_qty;
+  inc->time_seq = next_time_seq_++;
+  by_id_[order_id] = inc;
+
+  PriceLevel& lvl = levels_[index_of(price)];
+  const bool was_empty = lvl.empty();
+  lvl.push_back(inc);
+  if (was_empty) {
+    if (side == Side::Buy) chains_.bid_insert_sorted(lvl);
+    else                   chains_.ask_insert_sorted(lvl);
+  }
+
+  if (sink_) sink_->on_ack_add({order_id});
+  return {.accepted = true, .reject_reason = {}};
+}
+
+template <std::size_t N, PriceTicks Lo, PriceTicks Hi, PriceTicks W>
+bool FixedBook<N, Lo, Hi, W>::cancel(OrderId order_id) noexcept
+{
+  Order* order = order_id <= N ? by_id_[order_id] : nullptr;
+  if (order == nullptr) {
+    if (sink_) sink_->on_reject_cancel({order_id, "unknown order_id"});
+    return false;
+  }
+
+  PriceLevel& lvl = levels_[index_of(order->price_ticks)];
+  lvl.erase(order);
+  if (lvl.empty()) {
+    if (order->side == Side::Buy) chains_.bid_erase(lvl);
+    else                          chains_.ask_erase(lvl);
+  }
+  release(*order);
+
+  if (sink_) sink_->on_ack_cancel({order_id});
+  return true;
+}
+
+template <std::size_t N, PriceTicks Lo, PriceTicks Hi, PriceTicks W>
+template <Side S>
+void FixedBook<N, Lo, Hi, W>::match(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty) noexcept
+{
+  while (incoming_qty > 0) {
+    PriceLevel* lvl = (S == Side::Buy) ? chains_.best_ask : chains_.best_bid;
+    if (!lvl) break;
+    if (S == Side::Buy ? lvl->price_ticks > limit_price : lvl->price_ticks < limit_price) break;
+
+    while (incoming_qty > 0 && !lvl->empty()) {
+      Order* rest = lvl->head;
+      const Qty t = incoming_qty < rest->qty_remaining ? incoming_qty : rest->qty_remaining;
+      if (sink_) sink_->on_trade({.resting_id = rest->order_id, .incoming_id = incoming_id, .price = lvl->price_ticks, .qty = t});
+      last_trade_price_ = lvl->price_ticks;
+
+      rest->qty_remaining -= t;
+      lvl->total_qty -= t;
+      incoming_qty -= t;
+      if (rest->qty_remaining == 0) {
+        lvl->erase(rest);
+        release(*rest);
+      }
+    }
+
+    if (lvl->empty()) {
+      if (S == Side::Buy) chains_.ask_erase(*lvl);
+      else                chains_.bid_erase(*lvl);
+    }
+  }
+}
+
+} // namespace clob
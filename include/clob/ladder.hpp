@@ -13,6 +13,20 @@ struct LadderConfig {
   PriceTicks max_price_ticks{1'000'000};
 };
 
+// The bid and ask chains through the non-empty levels of a ladder: bids
+// highest first, asks lowest first. Knows nothing about where the levels are
+// stored, so Ladder and FixedBook share it.
+struct LevelChains {
+  PriceLevel* best_bid{nullptr};
+  PriceLevel* best_ask{nullptr};
+
+  void bid_insert_sorted(PriceLevel& lvl) noexcept;
+  void ask_insert_sorted(PriceLevel& lvl) noexcept;
+
+  void bid_erase(PriceLevel& lvl) noexcept;
+  void ask_erase(PriceLevel& lvl) noexcept;
+};
+
 class Ladder {
 public:
   explicit Ladder(LadderConfig cfg);
@@ -37,16 +51,9 @@ private:
   LadderConfig cfg_;
   std::vector<PriceLevel> levels_;
 
-  PriceLevel* best_bid_{nullptr};
-  PriceLevel* best_ask_{nullptr};
+  LevelChains chains_;
 
   [[nodiscard]] std::size_t index_of(PriceTicks p) const noexcept;
-
-  void bid_insert_sorted(PriceLevel& lvl) noexcept;
-  void ask_insert_sorted(PriceLevel& lvl) noexcept;
-
-  void bid_erase(PriceLevel& lvl) noexcept;
-  void ask_erase(PriceLevel& lvl) noexcept;
 };
 
 } // namespace clob
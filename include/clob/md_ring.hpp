@@ -0,0 +1,185 @@
+#pragma once
+
+#include "clob/types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <string_view>
+
+namespace clob {
+
+// Broadcast ring of fixed-size market-data records in POSIX shared memory.
+// One writer process appends; any number of reader processes map the segment
+// read-only and follow along with private cursors. The writer never waits for
+// readers: a reader that falls a full ring behind is told it was overrun.
+
+enum class MdRecordType : std::uint8_t {
+  AckAdd = 1,
+  RejectAdd,
+  AckCancel,
+  RejectCancel,
+  Trade,
+  Done,
+  LevelUpdate,
+  Heartbeat
+};
+
+struct MdRecord {
+  std::uint64_t ts_ns{};         // writer CLOCK_MONOTONIC stamp, 0 if not stamped
+  Qty qty{};                     // trade qty, or new level qty
+  PriceTicks price_ticks{};      // trade or level price
+  OrderId order_id{};            // resting id for trades
+  OrderId other_id{};            // incoming id for trades
+  MdRecordType type{};
+  std::uint8_t side{};           // Side of a level update
+  std::uint16_t reserved{};
+};
+
+struct MdSlot {
+  // cursor + 1 once the record for that cursor is complete, 0 while written.
+  alignas(64) std::atomic<std::uint64_t> seq;
+  std::atomic<std::uint64_t> words[sizeof(MdRecord) / sizeof(std::uint64_t)];
+};
+
+struct MdRingHeader {
+  static constexpr std::uint64_t magic_value = 0x636c6f626d647231ull;  // "clobmdr1"
+
+  std::uint64_t magic;
+  std::uint32_t record_size;
+  std::uint32_t slot_size;
+  std::uint64_t capacity;
+
+  // Records published so far; only consulted by readers on the slow path.
+  alignas(64) std::atomic<std::uint64_t> write_cursor;
+};
+
+static_assert(sizeof(MdRecord) % sizeof(std::uint64_t) == 0);
+static_assert(sizeof(MdSlot) == 64);
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free);
+
+struct MdRingResult {
+  bool ok;
+  std::optional<std::string_view> error;
+};
+
+[[nodiscard]] std::uint64_t md_now_ns() noexcept;
+
+class MdRingWriter {
+public:
+  MdRingWriter() = default;
+  ~MdRingWriter();
+
+  MdRingWriter(const MdRingWriter&) = delete;
+  MdRingWriter& operator=(const MdRingWriter&) = delete;
+
+  // Creates (or replaces) the shared-memory object /name with room for
+  // capacity records, rounded up to a power of two. The object is unlinked
+  // again when the writer is destroyed.
+  MdRingResult create(std::string_view name, std::size_t capacity);
+
+  void push(const MdRecord& record) noexcept;
+
+  [[nodiscard]] bool is_open() const noexcept { return slots_ != nullptr; }
+  [[nodiscard]] std::uint64_t cursor() const noexcept { return cursor_; }
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+private:
+  MdRingHeader* header_{nullptr};
+  MdSlot* slots_{nullptr};
+  std::size_t mask_{0};
+  std::uint64_t cursor_{0};
+
+  std::size_t map_size_{0};
+  char name_[64]{};
+};
+
+enum class MdReadStatus : std::uint8_t {
+  Ok,       // out holds the next record
+  Empty,    // nothing new yet
+  Overrun   // the writer lapped this reader; cursor moved to the live edge
+};
+
+class MdRingReader {
+public:
+  MdRingReader() = default;
+  ~MdRingReader();
+
+  MdRingReader(const MdRingReader&) = delete;
+  MdRingReader& operator=(const MdRingReader&) = delete;
+
+  // Maps an existing ring read-only. Reading starts at the live edge: only
+  // records pushed after open() are seen.
+  MdRingResult open(std::string_view name);
+
+  [[nodiscard]] MdReadStatus try_read(MdRecord& out) noexcept;
+
+  [[nodiscard]] bool is_open() const noexcept { return slots_ != nullptr; }
+  [[nodiscard]] std::uint64_t cursor() const noexcept { return cursor_; }
+  // Records skipped because of overruns.
+  [[nodiscard]] std::uint64_t lost() const noexcept { return lost_; }
+
+private:
+  const MdRingHeader* header_{nullptr};
+  const MdSlot* slots_{nullptr};
+  std::size_t mask_{0};
+  std::uint64_t cursor_{0};
+  std::uint64_t lost_{0};
+
+  std::size_t map_size_{0};
+};
+
+inline void MdRingWriter::push(const MdRecord& record) noexcept
+{
+  MdSlot& slot = slots_[cursor_ & mask_];
+  const auto* bytes = reinterpret_cast<const unsigned char*>(&record);
+
+  slot.seq.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (std::size_t i = 0; i < std::size(slot.words); ++i) {
+    std::uint64_t word;
+    std::memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+    slot.words[i].store(word, std::memory_order_relaxed);
+  }
+
+  ++cursor_;
+  slot.seq.store(cursor_, std::memory_order_release);
+  header_->write_cursor.store(cursor_, std::memory_order_release);
+}
+
+inline MdReadStatus MdRingReader::try_read(MdRecord& out) noexcept
+{
+  const MdSlot& slot = slots_[cursor_ & mask_];
+  const std::uint64_t want = cursor_ + 1;
+
+  const std::uint64_t seq = slot.seq.load(std::memory_order_acquire);
+  if (seq == want) {
+    auto* bytes = reinterpret_cast<unsigned char*>(&out);
+    for (std::size_t i = 0; i < std::size(slot.words); ++i) {
+      const std::uint64_t word = slot.words[i].load(std::memory_order_relaxed);
+      std::memcpy(bytes + i * sizeof(word), &word, sizeof(word));
+    }
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.seq.load(std::memory_order_relaxed) == want) {
+      cursor_ = want;
+      return MdReadStatus::Ok;
+    }
+  } else if (seq != 0 && seq < want) {
+    return MdReadStatus::Empty;
+  }
+
+  // The slot is mid-write or already holds a later lap; which one depends on
+  // how far the writer has got.
+  const std::uint64_t head = header_->write_cursor.load(std::memory_order_acquire);
+  if (head <= cursor_) return MdReadStatus::Empty;
+
+  lost_ += head - cursor_;
+  cursor_ = head;
+  return MdReadStatus::Overrun;
+}
+
+} // namespace clob
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "clob/book.hpp"
+#include "clob/md_ring.hpp"
+
+namespace clob {
+
+// EventSink that turns every Book event into one MdRecord on a shared-memory
+// ring. Mass cancels become one AckCancel record per order. With stamp set,
+// each record carries md_now_ns() so readers can measure latency.
+class MdRingSink final : public Book::EventSink {
+public:
+  explicit MdRingSink(MdRingWriter& ring, bool stamp = false) noexcept
+    : ring_(ring), stamp_(stamp) {}
+
+  void on_ack_add(const Book::AckAddEvent& e) override;
+  void on_reject_add(const Book::RejectAddEvent& e) override;
+  void on_ack_cancel(const Book::AckCancelEvent& e) override;
+  void on_reject_cancel(const Book::RejectCancelEvent& e) override;
+  void on_trade(const Book::TradeEvent& e) override;
+  void on_done(const Book::DoneEvent& e) override;
+  void on_mass_cancel(const Book::MassCancelEvent& e) override;
+  void on_level_update(const Book::LevelUpdateEvent& e) override;
+
+private:
+  MdRingWriter& ring_;
+  bool stamp_;
+
+  void push(MdRecord& record) noexcept;
+};
+
+} // namespace clob
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "clob/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace clob {
+
+// Order-entry wire protocol used by clob_server and clob_loadgen. Every
+// message is a fixed-size struct in host byte order (the server only listens
+// on loopback) whose first byte is its type; the type alone gives the size,
+// so a stream is decoded without length prefixes. Layouts are padded by hand
+// so the structs can be copied straight to and from the socket.
+
+enum class OeType : std::uint8_t {
+  // client -> server
+  Add = 1,
+  Cancel,
+  Amend,          // cancel/replace under the same id; the order loses priority
+  // server -> client
+  AckAdd = 16,
+  RejectAdd,
+  AckCancel,
+  RejectCancel,
+  Fill,
+  Done
+};
+
+// Add and Amend.
+struct OeOrder {
+  OeType type{};
+  std::uint8_t side{};            // Side
+  std::uint16_t reserved0{};
+  OrderId order_id{};
+  PriceTicks price_ticks{};
+  std::uint32_t reserved1{};
+  Qty qty{};
+};
+
+// Cancel, and the server's AckAdd, AckCancel and Done.
+struct OeId {
+  OeType type{};
+  std::uint8_t reserved0{};
+  std::uint16_t reserved1{};
+  OrderId order_id{};
+};
+
+struct OeReject {
+  static constexpr std::size_t reason_size = 24;
+
+  OeType type{};                  // RejectAdd or RejectCancel
+  std::uint8_t reserved0{};
+  std::uint16_t reserved1{};
+  OrderId order_id{};
+  char reason[reason_size]{};     // truncated, zero-padded
+};
+
+// One per side of a trade, sent to the owner of order_id.
+struct OeFill {
+  OeType type{OeType::Fill};
+  std::uint8_t aggressor{};       // 1 if order_id was the incoming order
+  std::uint16_t reserved0{};
+  OrderId order_id{};
+  PriceTicks price_ticks{};
+  std::uint32_t reserved1{};
+  Qty qty{};
+};
+
+static_assert(sizeof(OeOrder) == 24);
+static_assert(sizeof(OeId) == 8);
+static_assert(sizeof(OeReject) == 32);
+static_assert(sizeof(OeFill) == 24);
+
+inline constexpr std::size_t oe_max_message_size = sizeof(OeReject);
+
+// Wire size of a message of the given type; 0 for unknown types.
+[[nodiscard]] constexpr std::size_t oe_message_size(std::uint8_t type) noexcept
+{
+  switch (static_cast<OeType>(type)) {
+    case OeType::Add:
+    case OeType::Amend:
+    case OeType::Fill:
+      return sizeof(OeOrder);
+    case OeType::Cancel:
+    case OeType::AckAdd:
+    case OeType::AckCancel:
+    case OeType::Done:
+      return sizeof(OeId);
+    case OeType::RejectAdd:
+    case OeType::RejectCancel:
+      return sizeof(OeReject);
+  }
+  return 0;
+}
+
+[[nodiscard]] inline OeReject oe_reject(OeType type, OrderId order_id, std::string_view reason) noexcept
+{
+  OeReject r{.type = type, .order_id = order_id};
+  std::memcpy(r.reason, reason.data(), reason.size() < OeReject::reason_size ? reason.size()
+                                                                             : OeReject::reason_size);
+  return r;
+}
+
+} // namespace clob
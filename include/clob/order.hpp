@@ -1,7 +1,10 @@
 #pragma once
 
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "clob/types.hpp"
@@ -13,36 +16,99 @@ enum class Side : std::uint8_t {
   Sell
 };
 
+enum class OrderKind : std::uint8_t {
+  Limit,
+  Stop,
+  StopLimit
+};
+
+// The fields matching reads and writes come first and fill the first 48
+// bytes; the rest is only touched by icebergs, stops, sessions and risk.
 struct Order {
   OrderId    order_id{};
   Side       side{Side::Buy};
+  OrderKind  kind{OrderKind::Limit};
   PriceTicks price_ticks{};
+  // Slot in the level's queue-position index, when it has one.
+  std::uint32_t queue_slot{};
   Qty        qty_remaining{};
-
   std::uint64_t time_seq{};
   Order* prev{nullptr};
   Order* next{nullptr};
+
+  // Iceberg orders: qty_remaining is the visible slice, hidden_qty the reserve
+  // behind it and display_qty the slice size used to refill. Zero otherwise.
+  Qty hidden_qty{};
+  Qty display_qty{};
+
+  PriceTicks stop_price_ticks{};
+  // Owning session; 0 means untagged. Tagged orders are also linked into
+  // their session's list so a whole session can be cancelled at once.
+  SessionId session{};
+  // Risk account the order was entered under; its counters follow the order
+  // even if the session is remapped while it is live.
+  AccountId account{};
+  Order* session_prev{nullptr};
+  Order* session_next{nullptr};
   
   [[nodiscard]] auto is_live() const noexcept {
     return qty_remaining > 0;
   }
+
+  [[nodiscard]] auto has_reserve() const noexcept {
+    return hidden_qty > 0;
+  }
+
+  [[nodiscard]] auto is_pending_stop() const noexcept {
+    return kind != OrderKind::Limit;
+  }
 };
 
+// Segmented node pool. Nodes never move once handed out: fresh nodes are
+// carved from the current segment, recycled ones come off a free list. With a
+// non-zero segment_size the next segment is reserved up front and parked in
+// spare_, which allocate() adopts without allocating when the current segment
+// runs dry; refill() (any thread) parks a new spare once free_count() drops to
+// the low-water mark. allocate/free/free_chain belong to the owning thread.
 class OrderPool {
 public:
-  explicit OrderPool(std::size_t capacity);
+  explicit OrderPool(std::size_t capacity, std::size_t segment_size = 0, std::size_t low_water = 0);
+  ~OrderPool();
+
+  OrderPool(const OrderPool&) = delete;
+  OrderPool& operator=(const OrderPool&) = delete;
 
   Order* allocate();
   void free(Order* order);
+  void free_chain(Order* head, Order* tail, std::size_t count);
+
+  [[nodiscard]] bool can_allocate() const noexcept {
+    return free_head_ != nullptr || bump_ != bump_end_ || spare_.load(std::memory_order_relaxed) != nullptr;
+  }
+
+  [[nodiscard]] bool needs_refill() const noexcept;
+  bool refill();
 
-  [[nodiscard]] auto capacity() const noexcept;
-  [[nodiscard]] auto free_count() const noexcept;
+  [[nodiscard]] std::size_t capacity() const noexcept { return capacity_.load(std::memory_order_relaxed); }
+  [[nodiscard]] std::size_t free_count() const noexcept { return free_count_.load(std::memory_order_relaxed); }
 
 private:
-  std::vector<Order> storage_;
+  std::size_t segment_size_;
+  std::size_t low_water_;
+
   Order* free_head_{nullptr};
+  Order* bump_{nullptr};
+  Order* bump_end_{nullptr};
+
+  std::atomic<Order*> spare_{nullptr};
+  std::atomic<std::size_t> free_count_{0};
+  std::atomic<std::size_t> capacity_{0};
+
+  std::mutex segments_mutex_;
+  std::vector<std::unique_ptr<Order[]>> segments_;
 
-  std::size_t free_count_{0};
+  Order* new_segment(std::size_t n);
+  void set_free_count(std::size_t n) noexcept { free_count_.store(n, std::memory_order_relaxed); }
 };
 
 class OrderIdMap {
@@ -57,7 +123,7 @@ public:
 
   [[nodiscard]] bool exists(OrderId order_id) const noexcept;
 
-  [[nodiscard]] auto max_id() const noexcept;
+  [[nodiscard]] std::size_t max_id() const noexcept { return by_id_.size() - 1; }
 
 private:
   std::vector<Order*> by_id_;
@@ -2,6 +2,8 @@
 
 #include "clob/types.hpp"
 
+#include <cstdint>
+
 namespace clob {
 
 struct Order;
@@ -10,8 +12,17 @@ struct Order;
 
 namespace clob {
 
+// One cache line per level. Anything only an opt-in feature needs per level
+// (lazy-cancel counters, queue-position slots) lives in that feature's own
+// table rather than here.
 struct PriceLevel {
   PriceTicks price_ticks{};
+  // Queue-position block while the level is tracked, QueuePositionIndex::none
+  // otherwise.
+  std::uint16_t queue_index{0xffff};
+  bool in_bid{false};
+  bool in_ask{false};
+  Qty total_qty{};
 
   Order* head{nullptr};
   Order* tail{nullptr};
@@ -21,14 +32,14 @@ struct PriceLevel {
   PriceLevel* ask_prev{nullptr};
   PriceLevel* ask_next{nullptr};
 
-  bool in_bid{false};
-  bool in_ask{false};
-
   void push_back(Order* order) noexcept;
   Order* pop_front() noexcept;
   void erase(Order* order) noexcept;
+  void move_to_back(Order* order) noexcept;
   [[nodiscard]] auto empty() const noexcept { return head == nullptr; };
 };
 
+static_assert(sizeof(PriceLevel) == 64);
+
 }
 
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "clob/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace clob {
+
+// Fenwick trees over queue slots, one block per tracked price level. Orders
+// take slots in arrival order, so the prefix sum below an order's slot is the
+// quantity (and order count) ahead of it. Blocks come from a fixed pool and go
+// back once their level empties; by then every update has been undone, so a
+// returned block is already all zero. A block starts with slots_per_block
+// slots and doubles when its level outgrows it; on release it shrinks back but
+// keeps the memory, so only a new high-water mark allocates. Block ids are 16
+// bits so a level can hold one without growing PriceLevel.
+class QueuePositionIndex {
+public:
+  static constexpr std::uint16_t none = 0xffff;
+  static constexpr std::size_t max_blocks = none;
+
+  struct Sum {
+    Qty qty{};
+    std::int64_t orders{};
+  };
+
+  // At most max_blocks blocks; any more are ignored.
+  QueuePositionIndex(std::size_t blocks, std::uint32_t slots_per_block);
+
+  [[nodiscard]] std::uint32_t slots_per_block() const noexcept { return slots_; }
+  [[nodiscard]] std::uint32_t capacity(std::uint16_t block) const noexcept {
+    return static_cast<std::uint32_t>(trees_[block].size());
+  }
+
+  // none when every block is in use.
+  [[nodiscard]] std::uint16_t acquire() noexcept;
+  void release(std::uint16_t block) noexcept;
+  // For blocks dropped with updates still outstanding.
+  void clear(std::uint16_t block) noexcept;
+  // Doubles the block's slots and zeroes it; the caller re-adds its orders.
+  void grow(std::uint16_t block) noexcept;
+
+  // The slot the block's next arrival takes; 0 for a freshly acquired block.
+  [[nodiscard]] std::uint32_t next_slot(std::uint16_t block) const noexcept { return next_slot_[block]; }
+  void set_next_slot(std::uint16_t block, std::uint32_t slot) noexcept { next_slot_[block] = slot; }
+
+  void add(std::uint16_t block, std::uint32_t slot, Qty qty, std::int64_t orders) noexcept;
+  // Sum over slots [0, slot).
+  [[nodiscard]] Sum prefix(std::uint16_t block, std::uint32_t slot) const noexcept;
+
+private:
+  std::uint32_t slots_;
+  std::vector<std::vector<Sum>> trees_;
+  std::vector<std::uint32_t> next_slot_;
+  std::vector<std::uint16_t> free_blocks_;
+};
+
+} // namespace clob
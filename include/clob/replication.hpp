@@ -0,0 +1,287 @@
+#pragma once
+
+#include "clob/book.hpp"
+#include "clob/types.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <thread>
+
+namespace clob {
+
+// Command-stream replication for a hot standby. The primary sequences every
+// input command onto a single-producer ring in POSIX shared memory before
+// applying it; the replica applies the same commands in the same order to
+// its own Book and publishes how far it got. Book is deterministic, so two
+// books built with the same max_orders and BookConfig stay in lockstep.
+//
+// Unlike the market-data ring the stream is lossless: the primary waits for
+// the replica once it is a full ring ahead.
+
+enum class ReplCommandType : std::uint8_t {
+  AddLimit = 1,
+  AddIceberg,
+  AddStop,
+  AddStopLimit,
+  Cancel,
+  CancelSession,
+  CancelSide,
+  CancelPriceRange,
+  SetRiskLimits,
+  SetSessionAccount,
+  RefillPool
+};
+
+struct ReplCommand {
+  std::uint64_t ts_ns{};          // primary CLOCK_MONOTONIC stamp, 0 if not stamped
+  std::uint64_t state_hash{};     // primary's Book::state_hash() before this command
+  Qty qty{};                      // max_order_qty for SetRiskLimits
+  Qty display_qty{};              // max_open_notional for SetRiskLimits
+  OrderId order_id{};             // the account for SetRiskLimits / SetSessionAccount
+  PriceTicks price_ticks{};       // limit or stop price; lo for CancelPriceRange; price_band for SetRiskLimits
+  PriceTicks aux_price_ticks{};   // stop-limit's limit price; hi for CancelPriceRange
+  SessionId session{};
+  ReplCommandType type{};
+  Side side{};
+  std::uint16_t reserved0{};
+  // SetRiskLimits: max_position, split across aux_price_ticks (low 32 bits)
+  // and aux_hi (high 32 bits).
+  std::uint32_t aux_hi{};
+};
+
+struct ReplSlot {
+  // Sequence number (1-based) of the command in this slot once it is written.
+  alignas(64) std::atomic<std::uint64_t> seq;
+  ReplCommand command;
+};
+
+struct ReplRingHeader {
+  static constexpr std::uint64_t magic_value = 0x636c6f627265706cull;  // "clobrepl"
+
+  std::uint64_t magic;
+  std::uint32_t command_size;
+  std::uint32_t slot_size;
+  std::uint64_t capacity;
+
+  // Last sequence number published by the primary.
+  alignas(64) std::atomic<std::uint64_t> write_seq;
+  // Last sequence number the replica has applied; written only by it.
+  alignas(64) std::atomic<std::uint64_t> ack_seq;
+};
+
+static_assert(sizeof(ReplCommand) == 56);
+static_assert(sizeof(ReplSlot) == 64);
+
+struct ReplResult {
+  bool ok;
+  std::optional<std::string_view> error;
+};
+
+class ReplWriter {
+public:
+  ReplWriter() = default;
+  ~ReplWriter();
+
+  ReplWriter(const ReplWriter&) = delete;
+  ReplWriter& operator=(const ReplWriter&) = delete;
+
+  // Creates (or replaces) the shared-memory object /name with room for
+  // capacity commands, rounded up to a power of two. Unlinked on destruction.
+  ReplResult create(std::string_view name, std::size_t capacity);
+
+  // Assigns the next sequence number; yields while the ring is full.
+  std::uint64_t push(const ReplCommand& command) noexcept;
+
+  [[nodiscard]] bool is_open() const noexcept { return slots_ != nullptr; }
+  [[nodiscard]] std::uint64_t seq() const noexcept { return seq_; }
+  [[nodiscard]] std::uint64_t acked() const noexcept { return header_->ack_seq.load(std::memory_order_acquire); }
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask_ + 1; }
+
+private:
+  ReplRingHeader* header_{nullptr};
+  ReplSlot* slots_{nullptr};
+  std::size_t mask_{0};
+  std::uint64_t seq_{0};
+  // Last ack_seq seen; the shared line is only read again when this says the
+  // ring is full.
+  std::uint64_t acked_{0};
+
+  std::size_t map_size_{0};
+  char name_[64]{};
+};
+
+// Primary side: the Book command API, with each call shipped to the replica
+// before it is applied locally. Rejected commands are shipped too; the
+// replica rejects them the same way. Risk setup and pool refills change what
+// later commands do, so they go through here as well.
+class ReplicatedBook {
+public:
+  ReplicatedBook(Book& book, ReplWriter& writer, bool stamp = false) noexcept
+    : book_(book), writer_(writer), stamp_(stamp) {}
+
+  Book::AddResult add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price, SessionId session = 0)
+  {
+    ship({.qty = qty, .order_id = order_id, .price_ticks = price, .session = session,
+          .type = ReplCommandType::AddLimit, .side = side});
+    return book_.add_limit(order_id, qty, side, price, session);
+  }
+
+  Book::AddResult add_iceberg(OrderId order_id, Qty qty, Side side, PriceTicks price, Qty display_qty,
+                              SessionId session = 0)
+  {
+    ship({.qty = qty, .display_qty = display_qty, .order_id = order_id, .price_ticks = price,
+          .session = session, .type = ReplCommandType::AddIceberg, .side = side});
+    return book_.add_iceberg(order_id, qty, side, price, display_qty, session);
+  }
+
+  Book::AddResult add_stop(OrderId order_id, Qty qty, Side side, PriceTicks stop_price, SessionId session = 0)
+  {
+    ship({.qty = qty, .order_id = order_id, .price_ticks = stop_price, .session = session,
+          .type = ReplCommandType::AddStop, .side = side});
+    return book_.add_stop(order_id, qty, side, stop_price, session);
+  }
+
+  Book::AddResult add_stop_limit(OrderId order_id, Qty qty, Side side, PriceTicks stop_price,
+                                 PriceTicks limit_price, SessionId session = 0)
+  {
+    ship({.qty = qty, .order_id = order_id, .price_ticks = stop_price, .aux_price_ticks = limit_price,
+          .session = session, .type = ReplCommandType::AddStopLimit, .side = side});
+    return book_.add_stop_limit(order_id, qty, side, stop_price, limit_price, session);
+  }
+
+  bool cancel(OrderId order_id) noexcept
+  {
+    ship({.order_id = order_id, .type = ReplCommandType::Cancel});
+    return book_.cancel(order_id);
+  }
+
+  std::size_t cancel_session(SessionId session) noexcept
+  {
+    ship({.session = session, .type = ReplCommandType::CancelSession});
+    return book_.cancel_session(session);
+  }
+
+  std::size_t cancel_side(Side side) noexcept
+  {
+    ship({.type = ReplCommandType::CancelSide, .side = side});
+    return book_.cancel_side(side);
+  }
+
+  std::size_t cancel_price_range(Side side, PriceTicks lo, PriceTicks hi) noexcept
+  {
+    ship({.price_ticks = lo, .aux_price_ticks = hi, .type = ReplCommandType::CancelPriceRange, .side = side});
+    return book_.cancel_price_range(side, lo, hi);
+  }
+
+  bool set_risk_limits(AccountId account, const RiskLimits& limits) noexcept
+  {
+    const auto position = static_cast<std::uint64_t>(limits.max_position);
+    ship({.qty = limits.max_order_qty, .display_qty = limits.max_open_notional, .order_id = account,
+          .price_ticks = limits.price_band, .aux_price_ticks = static_cast<PriceTicks>(position & 0xffff'ffffu),
+          .type = ReplCommandType::SetRiskLimits, .aux_hi = static_cast<std::uint32_t>(position >> 32)});
+    return book_.set_risk_limits(account, limits);
+  }
+
+  bool set_session_account(SessionId session, AccountId account) noexcept
+  {
+    ship({.order_id = account, .session = session, .type = ReplCommandType::SetSessionAccount});
+    return book_.set_session_account(session, account);
+  }
+
+  // Unlike Book::refill_pool this must run on the thread making the other
+  // calls, since the ring has a single producer. The replica refills at the
+  // same point in the stream, so both pools grow alike.
+  bool refill_pool()
+  {
+    ship({.type = ReplCommandType::RefillPool});
+    return book_.refill_pool();
+  }
+
+  [[nodiscard]] Book& book() noexcept { return book_; }
+  [[nodiscard]] std::uint64_t seq() const noexcept { return writer_.seq(); }
+  // Commands shipped but not yet applied by the replica.
+  [[nodiscard]] std::uint64_t lag() const noexcept { return writer_.seq() - writer_.acked(); }
+
+private:
+  Book& book_;
+  ReplWriter& writer_;
+  bool stamp_;
+
+  void ship(ReplCommand command) noexcept;
+};
+
+// Replica side: follows a ring created by a ReplWriter and applies it to a
+// Book configured like the primary's.
+class Replica {
+public:
+  explicit Replica(Book& book) noexcept : book_(book) {}
+  ~Replica();
+
+  Replica(const Replica&) = delete;
+  Replica& operator=(const Replica&) = delete;
+
+  // Maps an existing ring and resumes after whatever was acked last.
+  ReplResult open(std::string_view name);
+
+  // Applies up to max_commands available commands, then acks the last one.
+  // Returns how many were applied.
+  std::size_t poll(std::size_t max_commands = 256) noexcept;
+
+  // Failover: applies everything the primary published, however much that is.
+  std::size_t drain() noexcept;
+
+  [[nodiscard]] bool is_open() const noexcept { return slots_ != nullptr; }
+  [[nodiscard]] std::uint64_t applied() const noexcept { return applied_; }
+  [[nodiscard]] std::uint64_t published() const noexcept {
+    return header_->write_seq.load(std::memory_order_acquire);
+  }
+  // First sequence number whose command arrived with a state hash different
+  // from this book's; commands keep being applied regardless.
+  [[nodiscard]] std::optional<std::uint64_t> diverged_at() const noexcept { return diverged_at_; }
+  // ts_ns of the last applied command, for lag measurements.
+  [[nodiscard]] std::uint64_t last_ts_ns() const noexcept { return last_ts_ns_; }
+
+private:
+  Book& book_;
+  ReplRingHeader* header_{nullptr};
+  const ReplSlot* slots_{nullptr};
+  std::size_t mask_{0};
+  std::uint64_t applied_{0};
+  std::uint64_t last_ts_ns_{0};
+  std::optional<std::uint64_t> diverged_at_;
+
+  std::size_t map_size_{0};
+
+  void apply(const ReplCommand& command) noexcept;
+};
+
+[[nodiscard]] std::uint64_t repl_now_ns() noexcept;
+
+inline std::uint64_t ReplWriter::push(const ReplCommand& command) noexcept
+{
+  const std::uint64_t seq = seq_ + 1;
+  while (seq - acked_ > mask_ + 1) {
+    acked_ = header_->ack_seq.load(std::memory_order_acquire);
+    if (seq - acked_ > mask_ + 1) std::this_thread::yield();
+  }
+
+  // The replica acked every earlier use of this slot, so nobody is reading it.
+  ReplSlot& slot = slots_[seq & mask_];
+  slot.command = command;
+  slot.seq.store(seq, std::memory_order_release);
+  header_->write_seq.store(seq, std::memory_order_release);
+  seq_ = seq;
+  return seq;
+}
+
+inline void ReplicatedBook::ship(ReplCommand command) noexcept
+{
+  if (stamp_) command.ts_ns = repl_now_ns();
+  command.state_hash = book_.state_hash();
+  (void)writer_.push(command);
+}
+
+} // namespace clob
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "clob/order.hpp"
+#include "clob/price_level.hpp"
+#include "clob/types.hpp"
+
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace clob {
+
+// Per-account pre-trade limits; 0 leaves a limit off.
+struct RiskLimits {
+  Qty max_order_qty{0};
+  // Sum of price_ticks * open qty (display + reserve) over resting orders,
+  // including the order being checked as if it rested in full.
+  Qty max_open_notional{0};
+  // |net filled qty| if the order being checked filled in full.
+  Qty max_position{0};
+  // How far a buy may be priced above the best ask (a sell below the best
+  // bid), in ticks. With that side empty the opposite touch is used instead.
+  PriceTicks price_band{0};
+};
+
+struct RiskState {
+  Qty open_notional{};
+  Qty position{};        // bought minus sold
+};
+
+// Dense per-account limits and counters, indexed directly by AccountId, with a
+// session -> account table in front. Everything is sized up front; checks and
+// updates are a couple of loads and adds.
+class RiskTable {
+public:
+  RiskTable(std::size_t max_accounts, std::size_t max_sessions);
+
+  [[nodiscard]] bool enabled() const noexcept { return enabled_; }
+  [[nodiscard]] std::size_t max_accounts() const noexcept { return accounts_.size(); }
+
+  bool set_limits(AccountId account, const RiskLimits& limits) noexcept;
+  bool set_session_account(SessionId session, AccountId account) noexcept;
+
+  [[nodiscard]] AccountId account_of(SessionId session) const noexcept { return session_account_[session]; }
+  [[nodiscard]] RiskState state(AccountId account) const noexcept;
+
+  // Reject reason, or nullopt if the order may go ahead.
+  [[nodiscard]] std::optional<std::string_view> check(AccountId account, Side side, PriceTicks price, Qty qty,
+                                                      const PriceLevel* best_bid,
+                                                      const PriceLevel* best_ask) const noexcept;
+  // A stop being entered. The band is measured from the stop price, where the
+  // market will be when it fires; a market stop (no limit_price) never rests
+  // and is only held to the qty and position limits.
+  [[nodiscard]] std::optional<std::string_view> check_stop(AccountId account, Side side, PriceTicks stop_price,
+                                                           std::optional<PriceTicks> limit_price,
+                                                           Qty qty) const noexcept;
+  // A triggered market stop, just before it trades.
+  [[nodiscard]] std::optional<std::string_view> check_market(AccountId account, Side side, Qty qty) const noexcept;
+
+  void on_rest(AccountId account, PriceTicks price, Qty qty) noexcept {
+    accounts_[account].state.open_notional += notional(price, qty);
+  }
+  void on_remove(AccountId account, PriceTicks price, Qty qty) noexcept {
+    accounts_[account].state.open_notional -= notional(price, qty);
+  }
+  void on_fill(AccountId account, Side side, Qty qty) noexcept {
+    accounts_[account].state.position += (side == Side::Buy) ? qty : -qty;
+  }
+  // A resting order traded: position moves and its open notional shrinks.
+  void on_resting_fill(AccountId account, Side side, PriceTicks price, Qty qty) noexcept {
+    RiskState& st = accounts_[account].state;
+    st.position += (side == Side::Buy) ? qty : -qty;
+    st.open_notional -= notional(price, qty);
+  }
+
+private:
+  struct Account {
+    RiskLimits limits;
+    RiskState state;
+  };
+
+  bool enabled_;
+  std::vector<Account> accounts_;
+  std::vector<AccountId> session_account_;
+
+  [[nodiscard]] static Qty notional(PriceTicks price, Qty qty) noexcept { return static_cast<Qty>(price) * qty; }
+
+  [[nodiscard]] static bool outside_band(Side side, PriceTicks price, PriceTicks ref, PriceTicks band) noexcept {
+    return side == Side::Buy ? price - ref > band : ref - price > band;
+  }
+  [[nodiscard]] static bool over_notional(const Account& acct, PriceTicks price, Qty qty) noexcept;
+  [[nodiscard]] static bool over_position(const Account& acct, Side side, Qty qty) noexcept;
+};
+
+inline std::optional<std::string_view> RiskTable::check(AccountId account, Side side, PriceTicks price, Qty qty,
+                                                        const PriceLevel* best_bid,
+                                                        const PriceLevel* best_ask) const noexcept
+{
+  const Account& acct = accounts_[account];
+  const RiskLimits& lim = acct.limits;
+
+  if (lim.max_order_qty != 0 && qty > lim.max_order_qty) return "risk: max order qty";
+
+  if (lim.price_band != 0) {
+    const PriceLevel* ref = (side == Side::Buy) ? (best_ask ? best_ask : best_bid) : (best_bid ? best_bid : best_ask);
+    if (ref && outside_band(side, price, ref->price_ticks, lim.price_band)) return "risk: price band";
+  }
+
+  if (over_notional(acct, price, qty)) return "risk: open notional";
+  if (over_position(acct, side, qty)) return "risk: position";
+  return std::nullopt;
+}
+
+inline std::optional<std::string_view> RiskTable::check_stop(AccountId account, Side side, PriceTicks stop_price,
+                                                             std::optional<PriceTicks> limit_price,
+                                                             Qty qty) const noexcept
+{
+  const Account& acct = accounts_[account];
+  const RiskLimits& lim = acct.limits;
+
+  if (lim.max_order_qty != 0 && qty > lim.max_order_qty) return "risk: max order qty";
+
+  if (limit_price) {
+    if (lim.price_band != 0 && outside_band(side, *limit_price, stop_price, lim.price_band)) return "risk: price band";
+    if (over_notional(acct, *limit_price, qty)) return "risk: open notional";
+  }
+
+  if (over_position(acct, side, qty)) return "risk: position";
+  return std::nullopt;
+}
+
+inline std::optional<std::string_view> RiskTable::check_market(AccountId account, Side side, Qty qty) const noexcept
+{
+  const Account& acct = accounts_[account];
+
+  if (acct.limits.max_order_qty != 0 && qty > acct.limits.max_order_qty) return "risk: max order qty";
+  if (over_position(acct, side, qty)) return "risk: position";
+  return std::nullopt;
+}
+
+// price fits in 31 bits, so the product only needs guarding for qty >= 2^32.
+inline bool RiskTable::over_notional(const Account& acct, PriceTicks price, Qty qty) noexcept
+{
+  if (acct.limits.max_open_notional == 0 || price <= 0) return false;
+  const Qty headroom = acct.limits.max_open_notional - acct.state.open_notional;
+  return (qty >> 32) == 0 ? notional(price, qty) > headroom : qty > headroom / price;
+}
+
+inline bool RiskTable::over_position(const Account& acct, Side side, Qty qty) noexcept
+{
+  if (acct.limits.max_position == 0) return false;
+  const Qty pos = acct.state.position;
+  const Qty headroom = (side == Side::Buy) ? acct.limits.max_position - pos : acct.limits.max_position + pos;
+  return qty > headroom;
+}
+
+} // namespace clob
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace clob {
+
+// Single-writer sequence lock over a trivially copyable T. The value is kept
+// as relaxed atomic words so readers racing a publish are well defined; a
+// reader that sees the sequence change (or odd) simply discards its copy.
+// Readers only load, so any number of them never write a shared cache line.
+template <class T>
+class Seqlock {
+  static_assert(std::is_trivially_copyable_v<T>);
+  static_assert(sizeof(T) % sizeof(std::uint64_t) == 0);
+
+public:
+  void store(const T& value) noexcept
+  {
+    const auto* bytes = reinterpret_cast<const unsigned char*>(&value);
+
+    const std::uint64_t seq = seq_.load(std::memory_order_relaxed);
+    seq_.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    for (std::size_t i = 0; i < word_count; ++i) {
+      std::uint64_t word;
+      std::memcpy(&word, bytes + i * sizeof(word), sizeof(word));
+      data_[i].store(word, std::memory_order_relaxed);
+    }
+
+    seq_.store(seq + 2, std::memory_order_release);
+  }
+
+  // One attempt, wait-free: false if a publish was in progress or overlapped,
+  // in which case out holds garbage.
+  [[nodiscard]] bool try_load(T& out) const noexcept
+  {
+    const std::uint64_t before = seq_.load(std::memory_order_acquire);
+    if (before & 1u) return false;
+
+    auto* bytes = reinterpret_cast<unsigned char*>(&out);
+    for (std::size_t i = 0; i < word_count; ++i) {
+      const std::uint64_t word = data_[i].load(std::memory_order_relaxed);
+      std::memcpy(bytes + i * sizeof(word), &word, sizeof(word));
+    }
+
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return seq_.load(std::memory_order_relaxed) == before;
+  }
+
+  [[nodiscard]] T load() const noexcept
+  {
+    T out;
+    while (!try_load(out)) {
+    }
+    return out;
+  }
+
+  // Number of completed stores.
+  [[nodiscard]] std::uint64_t version() const noexcept
+  {
+    return seq_.load(std::memory_order_acquire) / 2;
+  }
+
+private:
+  static constexpr std::size_t word_count = sizeof(T) / sizeof(std::uint64_t);
+
+  alignas(64) std::atomic<std::uint64_t> seq_{0};
+  alignas(64) std::atomic<std::uint64_t> data_[word_count];
+};
+
+} // namespace clob
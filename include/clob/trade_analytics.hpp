@@ -0,0 +1,200 @@
+#pragma once
+
+#include "clob/book.hpp"
+#include "clob/ladder.hpp"
+#include "clob/types.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace clob {
+
+// Running trade statistics for one instrument: VWAP and volume at each price
+// of a ladder grid, plus optional time and volume bars (OHLCV). Everything is
+// sized in the constructor; on_trade only updates counters in place. Replaying
+// recorded market data is in clob/analytics_replay.hpp (clob_md).
+
+struct Bar {
+  std::uint64_t start_ns{};   // interval start for time bars, first trade for volume bars
+  std::uint64_t last_ns{};    // last trade
+  PriceTicks open{};
+  PriceTicks high{};
+  PriceTicks low{};
+  PriceTicks close{};
+  Qty volume{};
+  Qty notional{};             // sum of price_ticks * qty
+  std::uint32_t trades{};     // a trade split across volume bars counts in each
+
+  [[nodiscard]] double vwap() const noexcept { return volume ? double(notional) / double(volume) : 0.0; }
+
+  void add(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept
+  {
+    if (trades == 0) {
+      open = high = low = price;
+      start_ns = ts_ns;
+    }
+    extend(price, qty, ts_ns);
+  }
+
+  // add() for a bar that already has a trade.
+  void extend(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept
+  {
+    high = price > high ? price : high;
+    low = price < low ? price : low;
+    close = price;
+    last_ns = ts_ns;
+    volume += qty;
+    notional += Qty{price} * qty;
+    ++trades;
+  }
+};
+
+// The open bar plus a ring of the most recently closed ones.
+class BarSeries {
+public:
+  explicit BarSeries(std::size_t history) : ring_(history != 0 ? history : 1) {}
+
+  // Bars closed so far, including any that have since dropped off the ring.
+  [[nodiscard]] std::uint64_t closed() const noexcept { return closed_; }
+  // Closed bars still held; [0] is the oldest, [size() - 1] the latest.
+  [[nodiscard]] std::size_t size() const noexcept { return closed_ < ring_.size() ? std::size_t(closed_) : ring_.size(); }
+  [[nodiscard]] const Bar& operator[](std::size_t i) const noexcept
+  {
+    return ring_[(next_ + ring_.size() - size() + i) % ring_.size()];
+  }
+  // The bar trades are going into; trades == 0 until one has.
+  [[nodiscard]] const Bar& current() const noexcept { return current_; }
+
+private:
+  friend class TradeAnalytics;
+
+  std::vector<Bar> ring_;
+  std::size_t next_{0};
+  std::uint64_t closed_{0};
+  Bar current_{};
+
+  void close() noexcept
+  {
+    ring_[next_] = current_;
+    if (++next_ == ring_.size()) next_ = 0;
+    ++closed_;
+    current_ = {};
+  }
+};
+
+struct AnalyticsConfig {
+  // Volume-at-price grid; trades outside it only count in off_grid_volume().
+  LadderConfig ladder{};
+  // Bars are off by default. With either kind on, every trade also takes an
+  // out-of-line call to update them.
+  // Time bars cover [k * interval, (k + 1) * interval) of the trade stamps;
+  // intervals without trades produce no bar. 0 turns time bars off.
+  std::uint64_t bar_interval_ns{0};
+  // Volume bars close at exactly this much volume, splitting the trade that
+  // crosses the boundary. 0 turns volume bars off.
+  Qty bar_volume{0};
+  // Closed bars kept per series; older ones are overwritten.
+  std::size_t bar_history{1024};
+};
+
+class TradeAnalytics {
+public:
+  explicit TradeAnalytics(AnalyticsConfig cfg = {});
+
+  // Stamps are expected not to go backwards; a trade stamped before the open
+  // time bar is counted in it.
+  void on_trade(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept;
+
+  [[nodiscard]] std::uint64_t trades() const noexcept { return trades_; }
+  [[nodiscard]] Qty volume() const noexcept { return volume_; }
+  [[nodiscard]] Qty notional() const noexcept { return notional_; }
+  [[nodiscard]] double vwap() const noexcept { return volume_ ? double(notional_) / double(volume_) : 0.0; }
+  [[nodiscard]] PriceTicks last_price() const noexcept { return last_price_; }
+
+  [[nodiscard]] const BarSeries& time_bars() const noexcept { return time_bars_; }
+  [[nodiscard]] const BarSeries& volume_bars() const noexcept { return volume_bars_; }
+
+  // Volume traded at p; 0 off the grid.
+  [[nodiscard]] Qty volume_at(PriceTicks p) const noexcept
+  {
+    const auto i = static_cast<std::uint64_t>(p - grid_min_);
+    return i < grid_size_ ? volume_at_price_[i] : 0;
+  }
+  // The whole histogram; entry i is price min_price_ticks + i.
+  [[nodiscard]] std::span<const Qty> volume_at_price() const noexcept { return volume_at_price_; }
+  [[nodiscard]] Qty off_grid_volume() const noexcept { return off_grid_volume_; }
+
+  [[nodiscard]] const AnalyticsConfig& config() const noexcept { return cfg_; }
+
+private:
+  AnalyticsConfig cfg_;
+
+  std::uint64_t trades_{0};
+  Qty volume_{0};
+  Qty notional_{0};
+  PriceTicks last_price_{0};
+
+  // The grid's first price and size, kept here so the histogram slot is one
+  // subtract and one compare against members already in cache.
+  std::int64_t grid_min_;
+  std::uint64_t grid_size_;
+  std::vector<Qty> volume_at_price_;
+  Qty off_grid_volume_{0};
+
+  bool bars_;
+  BarSeries time_bars_;
+  BarSeries volume_bars_;
+  std::uint64_t time_bar_end_{0};
+
+  void add_to_bars(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept;
+  void start_time_bar(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept;
+  void add_volume_bars(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept;
+};
+
+// Runs the analytics inline on the matching thread, in front of an optional
+// downstream sink that still receives every event. Trades take the stamp set
+// by set_time, typically the receive time of the command being applied.
+class AnalyticsSink final : public Book::EventSink {
+public:
+  explicit AnalyticsSink(TradeAnalytics& analytics, Book::EventSink* next = nullptr) noexcept
+    : analytics_(analytics), next_(next) {}
+
+  void set_time(std::uint64_t ts_ns) noexcept { ts_ns_ = ts_ns; }
+
+  void on_trade(const Book::TradeEvent& e) override
+  {
+    analytics_.on_trade(e.price, e.qty, ts_ns_);
+    if (next_) next_->on_trade(e);
+  }
+
+  void on_ack_add(const Book::AckAddEvent& e) override { if (next_) next_->on_ack_add(e); }
+  void on_reject_add(const Book::RejectAddEvent& e) override { if (next_) next_->on_reject_add(e); }
+  void on_ack_cancel(const Book::AckCancelEvent& e) override { if (next_) next_->on_ack_cancel(e); }
+  void on_reject_cancel(const Book::RejectCancelEvent& e) override { if (next_) next_->on_reject_cancel(e); }
+  void on_done(const Book::DoneEvent& e) override { if (next_) next_->on_done(e); }
+  void on_mass_cancel(const Book::MassCancelEvent& e) override { if (next_) next_->on_mass_cancel(e); }
+  void on_level_update(const Book::LevelUpdateEvent& e) override { if (next_) next_->on_level_update(e); }
+
+private:
+  TradeAnalytics& analytics_;
+  Book::EventSink* next_;
+  std::uint64_t ts_ns_{0};
+};
+
+inline void TradeAnalytics::on_trade(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept
+{
+  ++trades_;
+  volume_ += qty;
+  notional_ += Qty{price} * qty;
+  last_price_ = price;
+
+  const auto i = static_cast<std::uint64_t>(price - grid_min_);
+  if (i < grid_size_) volume_at_price_[i] += qty;
+  else off_grid_volume_ += qty;
+
+  if (bars_) add_to_bars(price, qty, ts_ns);
+}
+
+} // namespace clob
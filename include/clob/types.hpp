@@ -7,5 +7,7 @@ namespace clob {
   using OrderId = std::uint32_t;
   using PriceTicks = std::int32_t;
   using Qty = std::int64_t;
+  using SessionId = std::uint32_t;
+  using AccountId = std::uint32_t;
 
 }
@@ -0,0 +1,25 @@
+#include "clob/analytics_replay.hpp"
+
+#include <thread>
+#include <vector>
+
+namespace clob {
+
+void replay(TradeAnalytics& analytics, std::span<const MdRecord> records) noexcept
+{
+  for (const MdRecord& r : records) {
+    if (r.type == MdRecordType::Trade) analytics.on_trade(r.price_ticks, r.qty, r.ts_ns);
+  }
+}
+
+void replay_parallel(std::span<const AnalyticsJob> jobs)
+{
+  std::vector<std::thread> threads;
+  threads.reserve(jobs.size());
+  for (const AnalyticsJob& job : jobs) {
+    threads.emplace_back([job] { replay(*job.analytics, job.records); });
+  }
+  for (std::thread& t : threads) t.join();
+}
+
+} // namespace clob
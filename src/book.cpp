@@ -2,75 +2,267 @@
 #include "clob/price_level.hpp"
 #include "clob/order.hpp"
 
+#include <cassert>
+#include <limits>
+
 namespace clob {
 
-Book::Book(std::size_t max_orders)
-  : pool_(max_orders)
-  , id_map_(max_orders)
-  , ladder_(LadderConfig())
+Book::Book(std::size_t max_orders, BookConfig cfg)
+  : cfg_(cfg)
+  , pool_(max_orders, cfg.pool_segment_size, cfg.pool_low_water)
+  , id_map_(cfg.max_order_id != 0 ? cfg.max_order_id : max_orders)
+  , ladder_(cfg.ladder)
+  , session_heads_(cfg.max_sessions, nullptr)
+  , queue_index_(cfg.queue_position_levels, cfg.queue_position_slots)
+  , risk_(cfg.max_accounts, cfg.max_sessions)
+{
+  cancel_batch_.reserve(mass_cancel_batch_size);
+  if (cfg_.publish_depth > BookSnapshot::max_depth) cfg_.publish_depth = BookSnapshot::max_depth;
+  if (cfg_.lazy_cancel_compact_at == 0) cfg_.lazy_cancel_compact_at = 1;
+  if (cfg_.lazy_cancel) tombstones_.resize(static_cast<std::size_t>(cfg_.ladder.max_price_ticks - cfg_.ladder.min_price_ticks + 1));
+}
+
+// Nodes are laid out afresh rather than copied segment by segment: the pool
+// starts with the source's current capacity and each queue is rebuilt in
+// order, so every Order pointer in the copy lands in its own pool.
+Book::Book(const Book& other)
+  : cfg_(other.cfg_)
+  , pool_(other.pool_.capacity(), other.cfg_.pool_segment_size, other.cfg_.pool_low_water)
+  , id_map_(other.id_map_.max_id())
+  , ladder_(other.cfg_.ladder)
+  , next_time_seq_(other.next_time_seq_)
+  , last_trade_price_(other.last_trade_price_)
+  , state_hash_(other.state_hash_)
+  , session_heads_(other.session_heads_.size(), nullptr)
+  , queue_index_(other.cfg_.queue_position_levels, other.cfg_.queue_position_slots)
+  , risk_(other.risk_)
+  , publish_seq_(other.publish_seq_)
+  , publish_dirty_(other.publish_dirty_)
+  , publish_bid_floor_(other.publish_bid_floor_)
+  , publish_ask_ceiling_(other.publish_ask_ceiling_)
+{
+  cancel_batch_.reserve(mass_cancel_batch_size);
+  tombstones_.resize(other.tombstones_.size());
+
+  copy_chain(other.ladder_, ladder_, Side::Buy);
+  copy_chain(other.ladder_, ladder_, Side::Sell);
+  if (other.stops_) {
+    stops_ = std::make_unique<StopLadders>(Ladder(cfg_.ladder), Ladder(cfg_.ladder));
+    copy_chain(other.stops_->buys, stops_->buys, Side::Sell);
+    copy_chain(other.stops_->sells, stops_->sells, Side::Buy);
+  }
+
+  // link_session pushes at the head, so relink each list from its tail.
+  for (std::size_t s = 1; s < other.session_heads_.size(); ++s) {
+    const Order* o = other.session_heads_[s];
+    while (o && o->session_next) o = o->session_next;
+    for (; o; o = o->session_prev) link_session(*id_map_.get(o->order_id));
+  }
+
+  snapshot_.store(other.snapshot_.load());
+}
+
+// Copies one chain of `from` (the bid chain for Buy) into the same levels of
+// `to`. Levels go in worst first so each lands at the front of its chain, and
+// a level that had a queue-position block gets one again. Tombstones are left
+// behind.
+void Book::copy_chain(const Ladder& from, Ladder& to, Side chain)
 {
+  const bool bids = chain == Side::Buy;
+  const PriceLevel* src = bids ? from.best_bid_level() : from.best_ask_level();
+  while (src && (bids ? src->bid_next : src->ask_next)) src = bids ? src->bid_next : src->ask_next;
+
+  for (; src; src = bids ? src->bid_prev : src->ask_prev) {
+    PriceLevel& lvl = to.level_at(src->price_ticks);
+    for (const Order* o = src->head; o != nullptr; o = o->next) {
+      if (!o->is_live()) continue;
+      Order* node = pool_.allocate();
+      *node = *o;
+      node->prev = nullptr;
+      node->next = nullptr;
+      node->session_prev = nullptr;
+      node->session_next = nullptr;
+      lvl.push_back(node);
+      id_map_.set(node->order_id, node);
+    }
+
+    if (bids) to.on_bid_level_became_non_empty(lvl);
+    else      to.on_ask_level_became_non_empty(lvl);
 
+    if (src->queue_index != QueuePositionIndex::none) {
+      lvl.queue_index = queue_index_.acquire();
+      if (lvl.queue_index == QueuePositionIndex::none) continue;
+      for (Order* o = lvl.head; o != nullptr; o = o->next) queue_track(lvl, *o);
+    }
+  }
 }
 
 static inline Qty min_qty(Qty a, Qty b) { return (a < b) ? a : b; }
 
-void Book::match_buy(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty) {
-  while (incoming_qty > 0) {
-    PriceLevel* lvl = ladder_.best_ask_level();
-    if (!lvl) break;
-    if (lvl->price_ticks > limit_price) break;
+// State hash: the sum of key * weight over resting orders, where the key mixes
+// the order's identity and queue position and the weight is its qty. A fill
+// then only subtracts key * qty, and a full walk gives the same value whatever
+// order the orders are visited in.
+static inline std::uint64_t state_key(const Order& o)
+{
+  std::uint64_t x = (std::uint64_t(o.order_id) << 32 | std::uint32_t(o.price_ticks))
+                  ^ (o.time_seq * 0x9e3779b97f4a7c15ull) ^ (std::uint64_t(o.side) << 31);
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x | 1;
+}
 
-    while (incoming_qty > 0 && !lvl->empty()) {
-      Order* rest = lvl->head;
-      Qty t = min_qty(incoming_qty, rest->qty_remaining);
+// Reserve is weighted apart from the displayed slice so a refill, which
+// moves qty between the two, changes the hash.
+static inline std::uint64_t state_term(const Order& o)
+{
+  return state_key(o) * (std::uint64_t(o.qty_remaining) + std::uint64_t(o.hidden_qty) * 0xd6e8feb86659fd93ull);
+}
 
-      if (sink_) sink_->on_trade({.resting_id = rest->order_id, .incoming_id = incoming_id, .price = rest->price_ticks, .qty = t});
+// floor(available * qty / total) for available < total and qty <= total: the
+// result always fits, only the product can overflow.
+static inline Qty pro_rata_share(Qty available, Qty qty, Qty total)
+{
+  if (qty != 0 && available > std::numeric_limits<Qty>::max() / qty) {
+    return static_cast<Qty>(static_cast<long double>(available) * static_cast<long double>(qty) / static_cast<long double>(total));
+  }
+  return (available * qty) / total;
+}
 
-      incoming_qty -= t;
-      rest->qty_remaining -= t;
-      
-      if (rest->qty_remaining == 0) {
-        Order* done = lvl->pop_front();
-        id_map_.clear(done->order_id);
-        pool_.free(done);
-      }
+// Also the snapshot's change detector: only a level at or inside the depth
+// published last time can alter it. Trades always touch the best level, so
+// the last trade price is covered too.
+inline void Book::level_update(Side side, const PriceLevel& lvl) noexcept
+{
+  if (cfg_.level_updates && sink_) sink_->on_level_update({.side = side, .price = lvl.price_ticks, .qty = lvl.total_qty});
+  if (side == Side::Buy ? lvl.price_ticks >= publish_bid_floor_ : lvl.price_ticks <= publish_ask_ceiling_) {
+    publish_dirty_ = true;
+  }
+}
 
-      if (lvl->empty()) {
-        ladder_.on_ask_level_became_empty(*lvl);
-      }
+inline void Book::fill(PriceLevel& lvl, Order& rest, OrderId incoming_id, Qty qty)
+{
+  if (sink_) sink_->on_trade({.resting_id = rest.order_id, .incoming_id = incoming_id, .price = rest.price_ticks, .qty = qty});
+  last_trade_price_ = rest.price_ticks;
+
+  state_hash_ -= state_key(rest) * std::uint64_t(qty);
+  rest.qty_remaining -= qty;
+  lvl.total_qty -= qty;
+  if (risk_.enabled()) risk_.on_resting_fill(rest.account, rest.side, rest.price_ticks, qty);
+  if (lvl.queue_index != QueuePositionIndex::none) {
+    queue_index_.add(lvl.queue_index, rest.queue_slot, -qty, rest.qty_remaining == 0 ? -1 : 0);
+  }
+
+  if (rest.qty_remaining == 0 && rest.has_reserve()) {
+    replenish(lvl, rest);
+  } else if (rest.qty_remaining == 0) {
+    lvl.erase(&rest);
+    release(rest);
+  }
+}
+
+inline void Book::fill_fifo(PriceLevel& lvl, OrderId incoming_id, Qty& incoming_qty)
+{
+  while (incoming_qty > 0 && !lvl.empty()) {
+    Order* rest = lvl.head;
+    if (!rest->is_live()) {
+      reap(lvl, *rest);
+      continue;
+    }
+    Qty t = min_qty(incoming_qty, rest->qty_remaining);
+    fill(lvl, *rest, incoming_id, t);
+    incoming_qty -= t;
+  }
+}
+
+// One pass over the queue using the level's aggregate quantity, then whatever
+// rounding and the minimum allocation left over is handed out FIFO.
+void Book::fill_pro_rata(PriceLevel& lvl, OrderId incoming_id, Qty& incoming_qty)
+{
+  const Qty total = lvl.total_qty;
+  if (incoming_qty < total) {
+    const Qty available = incoming_qty;
+    for (Order* rest = lvl.head; rest != nullptr; rest = rest->next) {
+      const Qty share = pro_rata_share(available, rest->qty_remaining, total);
+      if (share == 0 || share < cfg_.pro_rata_min_qty) continue;
+      fill(lvl, *rest, incoming_id, share);
+      incoming_qty -= share;
     }
   }
+
+  fill_fifo(lvl, incoming_id, incoming_qty);
 }
 
-void Book::match_sell(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty) {
+template <Side S, MatchPolicy P>
+void Book::match(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty)
+{
   while (incoming_qty > 0) {
-    PriceLevel* lvl = ladder_.best_bid_level();
+    PriceLevel* lvl = (S == Side::Buy) ? ladder_.best_ask_level() : ladder_.best_bid_level();
     if (!lvl) break;
-    if (lvl->price_ticks < limit_price) break;
-
-    while (incoming_qty > 0 && !lvl->empty()) {
-      Order* rest = lvl->head;
-      Qty t = min_qty(incoming_qty, rest->qty_remaining);
-      
-      if (sink_) sink_->on_trade({.resting_id = rest->order_id, .incoming_id = incoming_id, .price = rest->price_ticks, .qty = t});
+    if (S == Side::Buy ? lvl->price_ticks > limit_price : lvl->price_ticks < limit_price) break;
 
+    if constexpr (P == MatchPolicy::Fifo) {
+      fill_fifo(*lvl, incoming_id, incoming_qty);
+    } else if constexpr (P == MatchPolicy::ProRata) {
+      fill_pro_rata(*lvl, incoming_id, incoming_qty);
+    } else {
+      while (!lvl->head->is_live()) reap(*lvl, *lvl->head);
+      Order* top = lvl->head;
+      Qty t = min_qty(incoming_qty, top->qty_remaining);
+      fill(*lvl, *top, incoming_id, t);
       incoming_qty -= t;
-      rest->qty_remaining -= t;
-
-      if (rest->qty_remaining == 0) {
-        Order* done = lvl->pop_front();
-        id_map_.clear(done->order_id);
-        pool_.free(done);
-      }
+      if (incoming_qty > 0 && lvl->total_qty != 0) fill_pro_rata(*lvl, incoming_id, incoming_qty);
     }
 
-    if (lvl->empty()) {
-      ladder_.on_bid_level_became_empty(*lvl);
-    }
+    level_update(S == Side::Buy ? Side::Sell : Side::Buy, *lvl);
+
+    if (lvl->total_qty == 0) level_drained(*lvl, S == Side::Buy ? Side::Sell : Side::Buy);
   }
 }
 
-Book::AddResult Book::add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price) 
+void Book::match_buy(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty)
+{
+  switch (cfg_.match_policy) {
+    case MatchPolicy::Fifo:            match<Side::Buy, MatchPolicy::Fifo>(incoming_id, limit_price, incoming_qty); break;
+    case MatchPolicy::ProRata:         match<Side::Buy, MatchPolicy::ProRata>(incoming_id, limit_price, incoming_qty); break;
+    case MatchPolicy::TopOrderProRata: match<Side::Buy, MatchPolicy::TopOrderProRata>(incoming_id, limit_price, incoming_qty); break;
+  }
+}
+
+void Book::match_sell(OrderId incoming_id, PriceTicks limit_price, Qty& incoming_qty)
+{
+  switch (cfg_.match_policy) {
+    case MatchPolicy::Fifo:            match<Side::Sell, MatchPolicy::Fifo>(incoming_id, limit_price, incoming_qty); break;
+    case MatchPolicy::ProRata:         match<Side::Sell, MatchPolicy::ProRata>(incoming_id, limit_price, incoming_qty); break;
+    case MatchPolicy::TopOrderProRata: match<Side::Sell, MatchPolicy::TopOrderProRata>(incoming_id, limit_price, incoming_qty); break;
+  }
+}
+
+Book::AddResult Book::add_limit(OrderId order_id, Qty qty, Side side, PriceTicks price, SessionId session) 
+{
+  const AddResult res = add_order(order_id, qty, side, price, 0, session);
+  if (res.accepted) auto_publish();
+  return res;
+}
+
+Book::AddResult Book::add_iceberg(OrderId order_id, Qty qty, Side side, PriceTicks price, Qty display_qty,
+                                  SessionId session)
+{
+  if (qty > 0 && (display_qty <= 0 || display_qty > qty)) {
+    if (sink_) sink_->on_reject_add({order_id, "invalid display qty"});
+    return {.accepted = false, .reject_reason = "invalid display qty"};
+  }
+
+  const AddResult res = add_order(order_id, qty, side, price, display_qty, session);
+  if (res.accepted) auto_publish();
+  return res;
+}
+
+Book::AddResult Book::add_order(OrderId order_id, Qty qty, Side side, PriceTicks price, Qty display_qty,
+                                SessionId session)
 {
   if (qty <= 0) {
     if (sink_) sink_->on_reject_add({order_id, "qty <= 0"});
@@ -82,45 +274,288 @@ Book::AddResult Book::add_limit(OrderId order_id, Qty qty, Side side, PriceTicks
     return {.accepted = false, .reject_reason = "invalid price"};
   }
 
+  if (order_id == 0 || order_id > id_map_.max_id()) {
+    if (sink_) sink_->on_reject_add({order_id, "invalid order_id"});
+    return {.accepted = false, .reject_reason = "invalid order_id"};
+  }
+
   if (id_map_.exists(order_id)) {
     if (sink_) sink_->on_reject_add({order_id, "duplicate order_id"});
     return {.accepted = false, .reject_reason = "duplicate order_id"};
   }
 
+  if (session != 0 && session >= session_heads_.size()) {
+    if (sink_) sink_->on_reject_add({order_id, "invalid session"});
+    return {.accepted = false, .reject_reason = "invalid session"};
+  }
+
+  // Checked before matching so an order is never partly executed and then
+  // dropped for want of a node to rest the remainder on.
+  if (!pool_.can_allocate() && cfg_.lazy_cancel) reclaim_tombstones();
+  if (!pool_.can_allocate()) {
+    if (sink_) sink_->on_reject_add({order_id, "pool full"});
+    return {.accepted = false, .reject_reason = "pool full"};
+  }
+
+  const AccountId account = risk_.enabled() ? risk_.account_of(session) : 0;
+  if (risk_.enabled()) {
+    const auto reason = risk_.check(account, side, price, qty, ladder_.best_bid_level(), ladder_.best_ask_level());
+    if (reason) {
+      if (sink_) sink_->on_reject_add({order_id, *reason});
+      return {.accepted = false, .reject_reason = reason};
+    }
+  }
+
  Qty incoming_qty = qty;
 
   if (side == Side::Buy) match_buy(order_id, price, incoming_qty);
   else                  match_sell(order_id, price, incoming_qty);
 
+  if (risk_.enabled() && incoming_qty != qty) risk_.on_fill(account, side, qty - incoming_qty);
+
   if (incoming_qty == 0) {
+    trigger_stops();
     return {.accepted = true, .reject_reason = {}};
   }
 
   Order* inc = pool_.allocate();
-  if (!inc) return {.accepted = false, .reject_reason = "pool full"};
+  assert(inc != nullptr);
 
   inc->order_id = order_id;
   inc->side = side;
   inc->price_ticks = price;
   inc->qty_remaining = incoming_qty;
+  if (display_qty > 0 && incoming_qty > display_qty) {
+    inc->display_qty = display_qty;
+    inc->hidden_qty = incoming_qty - display_qty;
+    inc->qty_remaining = display_qty;
+  }
   inc->prev = nullptr;
   inc->next = nullptr;
+  inc->session = session;
+  inc->account = account;
   assign_time_seq(*inc);
 
   id_map_.set(order_id, inc);
+  if (session != 0) link_session(*inc);
+  rest_order(inc);
 
-  PriceLevel& lvl = ladder_.level_at(price);
-  bool was_empty = lvl.empty();
-  lvl.push_back(inc);
-  if (was_empty) {
-    if (side == Side::Buy) ladder_.on_bid_level_became_non_empty(lvl);
-    else                  ladder_.on_ask_level_became_non_empty(lvl);
+  if (sink_) sink_->on_ack_add({order_id});
+  trigger_stops();
+  return {.accepted = true, .reject_reason = {}};
+}
+
+Book::AddResult Book::add_stop(OrderId order_id, Qty qty, Side side, PriceTicks stop_price, SessionId session)
+{
+  const AddResult res = add_stop_order(order_id, qty, side, OrderKind::Stop, stop_price, stop_price, session);
+  if (res.accepted) auto_publish();
+  return res;
+}
+
+Book::AddResult Book::add_stop_limit(OrderId order_id, Qty qty, Side side, PriceTicks stop_price, PriceTicks limit_price,
+                                     SessionId session)
+{
+  const AddResult res = add_stop_order(order_id, qty, side, OrderKind::StopLimit, stop_price, limit_price, session);
+  if (res.accepted) auto_publish();
+  return res;
+}
+
+Book::AddResult Book::add_stop_order(OrderId order_id, Qty qty, Side side, OrderKind kind,
+                                     PriceTicks stop_price, PriceTicks limit_price, SessionId session)
+{
+  if (qty <= 0) {
+    if (sink_) sink_->on_reject_add({order_id, "qty <= 0"});
+    return {.accepted = false, .reject_reason = "qty <= 0"};
+  }
+
+  if (!ladder_.is_valid_price(stop_price) || !ladder_.is_valid_price(limit_price)) {
+    if (sink_) sink_->on_reject_add({order_id, "invalid price"});
+    return {.accepted = false, .reject_reason = "invalid price"};
+  }
+
+  if (order_id == 0 || order_id > id_map_.max_id()) {
+    if (sink_) sink_->on_reject_add({order_id, "invalid order_id"});
+    return {.accepted = false, .reject_reason = "invalid order_id"};
+  }
+
+  if (id_map_.exists(order_id)) {
+    if (sink_) sink_->on_reject_add({order_id, "duplicate order_id"});
+    return {.accepted = false, .reject_reason = "duplicate order_id"};
+  }
+
+  if (session != 0 && session >= session_heads_.size()) {
+    if (sink_) sink_->on_reject_add({order_id, "invalid session"});
+    return {.accepted = false, .reject_reason = "invalid session"};
+  }
+
+  const AccountId account = risk_.enabled() ? risk_.account_of(session) : 0;
+  if (risk_.enabled()) {
+    const auto limit = kind == OrderKind::StopLimit ? std::optional<PriceTicks>(limit_price) : std::nullopt;
+    const auto reason = risk_.check_stop(account, side, stop_price, limit, qty);
+    if (reason) {
+      if (sink_) sink_->on_reject_add({order_id, *reason});
+      return {.accepted = false, .reject_reason = reason};
+    }
+  }
+
+  if (!pool_.can_allocate() && cfg_.lazy_cancel) reclaim_tombstones();
+  Order* stop = pool_.allocate();
+  if (!stop) {
+    if (sink_) sink_->on_reject_add({order_id, "pool full"});
+    return {.accepted = false, .reject_reason = "pool full"};
+  }
+
+  stop->order_id = order_id;
+  stop->side = side;
+  stop->kind = kind;
+  stop->price_ticks = limit_price;
+  stop->stop_price_ticks = stop_price;
+  stop->qty_remaining = qty;
+  stop->session = session;
+  stop->account = account;
+  assign_time_seq(*stop);
+
+  id_map_.set(order_id, stop);
+  if (session != 0) link_session(*stop);
+
+  if (!stops_) stops_ = std::make_unique<StopLadders>(Ladder(cfg_.ladder), Ladder(cfg_.ladder));
+
+  if (side == Side::Buy) {
+    PriceLevel& lvl = stops_->buys.level_at(stop_price);
+    lvl.push_back(stop);
+    stops_->buys.on_ask_level_became_non_empty(lvl);
+  } else {
+    PriceLevel& lvl = stops_->sells.level_at(stop_price);
+    lvl.push_back(stop);
+    stops_->sells.on_bid_level_became_non_empty(lvl);
   }
 
   if (sink_) sink_->on_ack_add({order_id});
+
+  // A stop that is already through the last trade fires straight away.
+  trigger_stops();
   return {.accepted = true, .reject_reason = {}};
 }
 
+void Book::rest_order(Order* order) noexcept
+{
+  PriceLevel& lvl = ladder_.level_at(order->price_ticks);
+  bool was_empty = lvl.empty();
+  lvl.push_back(order);
+  if (was_empty) {
+    if (order->side == Side::Buy) ladder_.on_bid_level_became_non_empty(lvl);
+    else                         ladder_.on_ask_level_became_non_empty(lvl);
+    if (cfg_.queue_position_levels != 0) lvl.queue_index = queue_index_.acquire();
+  }
+  if (lvl.queue_index != QueuePositionIndex::none) queue_track(lvl, *order);
+  state_hash_ += state_term(*order);
+  if (risk_.enabled()) {
+    risk_.on_rest(order->account, order->price_ticks, order->qty_remaining + order->hidden_qty);
+  }
+  level_update(order->side, lvl);
+}
+
+// An exhausted iceberg slice is refilled from its reserve in place: the same
+// node takes a new time_seq and is relinked at the tail of its level.
+void Book::replenish(PriceLevel& lvl, Order& order) noexcept
+{
+  const Qty slice = min_qty(order.display_qty, order.hidden_qty);
+  state_hash_ -= state_term(order);
+  lvl.move_to_back(&order);
+  order.hidden_qty -= slice;
+  order.qty_remaining = slice;
+  lvl.total_qty += slice;
+  assign_time_seq(order);
+  state_hash_ += state_term(order);
+  if (lvl.queue_index != QueuePositionIndex::none) queue_track(lvl, order);
+}
+
+void Book::unlink_stop(Order& order) noexcept
+{
+  if (order.side == Side::Buy) {
+    PriceLevel& lvl = stops_->buys.level_at(order.stop_price_ticks);
+    lvl.erase(&order);
+    if (lvl.empty()) stops_->buys.on_ask_level_became_empty(lvl);
+  } else {
+    PriceLevel& lvl = stops_->sells.level_at(order.stop_price_ticks);
+    lvl.erase(&order);
+    if (lvl.empty()) stops_->sells.on_bid_level_became_empty(lvl);
+  }
+}
+
+Order* Book::next_triggered_stop() const noexcept
+{
+  if (!stops_ || !last_trade_price_) return nullptr;
+  const PriceTicks last = *last_trade_price_;
+
+  PriceLevel* buy = stops_->buys.best_ask_level();
+  PriceLevel* sell = stops_->sells.best_bid_level();
+  const bool buy_hit = buy && buy->price_ticks <= last;
+  const bool sell_hit = sell && sell->price_ticks >= last;
+
+  if (buy_hit && sell_hit) {
+    return (buy->head->time_seq < sell->head->time_seq) ? buy->head : sell->head;
+  }
+  if (buy_hit) return buy->head;
+  if (sell_hit) return sell->head;
+  return nullptr;
+}
+
+// The book has moved since the stop was entered, so it is checked again as
+// the order it turns into; one that no longer passes is dropped with on_done.
+void Book::release_stop(Order* order)
+{
+  unlink_stop(*order);
+
+  const bool is_market = order->kind == OrderKind::Stop;
+  if (risk_.enabled()) {
+    const auto reason = is_market
+      ? risk_.check_market(order->account, order->side, order->qty_remaining)
+      : risk_.check(order->account, order->side, order->price_ticks, order->qty_remaining,
+                    ladder_.best_bid_level(), ladder_.best_ask_level());
+    if (reason) {
+      const OrderId order_id = order->order_id;
+      release(*order);
+      if (sink_) sink_->on_done({order_id});
+      return;
+    }
+  }
+
+  order->kind = OrderKind::Limit;
+  if (is_market) {
+    order->price_ticks = (order->side == Side::Buy) ? ladder_.max_price_ticks() : ladder_.min_price_ticks();
+  }
+
+  Qty qty = order->qty_remaining;
+  if (order->side == Side::Buy) match_buy(order->order_id, order->price_ticks, qty);
+  else                         match_sell(order->order_id, order->price_ticks, qty);
+
+  if (risk_.enabled() && qty != order->qty_remaining) {
+    risk_.on_fill(order->account, order->side, order->qty_remaining - qty);
+  }
+
+  if (qty == 0 || is_market) {
+    const OrderId order_id = order->order_id;
+    release(*order);
+    if (qty != 0 && sink_) sink_->on_done({order_id});
+    return;
+  }
+
+  order->qty_remaining = qty;
+  assign_time_seq(*order);
+  rest_order(order);
+}
+
+// Each release can print new trades and move the last price through further
+// stop levels, so keep pulling the best triggered stop until none is left.
+// Only the crossed levels at the front of each stop chain are ever visited.
+void Book::trigger_stops()
+{
+  while (Order* stop = next_triggered_stop()) {
+    release_stop(stop);
+  }
+}
+
 void Book::assign_time_seq(Order& order) noexcept
 {
   order.time_seq = next_time_seq_++;
@@ -134,17 +569,465 @@ bool Book::cancel(OrderId order_id) noexcept
     return false;
   }
 
-  PriceLevel& lvl = ladder_.level_at(order->price_ticks);
-  lvl.erase(order);
-  if (lvl.empty()) {
-    if (order->side == Side::Buy) ladder_.on_bid_level_became_empty(lvl);
-    else ladder_.on_ask_level_became_empty(lvl);
-  } 
-
-  id_map_.clear(order_id);
-  pool_.free(order);
+  // Head and tail have one neighbour to patch, so only interior nodes are
+  // worth deferring.
+  if (cfg_.lazy_cancel && !order->is_pending_stop() && order->prev && order->next) {
+    tombstone(*order);
+  } else {
+    unlink_from_book(*order);
+    release(*order);
+  }
 
   if (sink_) sink_->on_ack_cancel({order_id});
+  auto_publish();
   return true;
 }
+
+std::size_t Book::cancel_session(SessionId session) noexcept
+{
+  if (session == 0 || session >= session_heads_.size()) return 0;
+
+  std::size_t n = 0;
+  Order* order = session_heads_[session];
+  session_heads_[session] = nullptr;
+
+  while (order) {
+    Order* next = order->session_next;
+    const OrderId order_id = order->order_id;
+
+    unlink_from_book(*order);
+    order->session = 0;
+    order->session_prev = nullptr;
+    order->session_next = nullptr;
+    release(*order);
+
+    batch_cancel(order_id);
+    ++n;
+    order = next;
+  }
+
+  flush_cancel_batch();
+  auto_publish();
+  return n;
+}
+
+std::size_t Book::cancel_side(Side side) noexcept
+{
+  std::size_t n = 0;
+
+  if (side == Side::Buy) {
+    while (PriceLevel* lvl = ladder_.best_bid_level()) {
+      n += cancel_level(*lvl);
+      level_update(Side::Buy, *lvl);
+      ladder_.on_bid_level_became_empty(*lvl);
+    }
+    while (PriceLevel* lvl = stops_ ? stops_->buys.best_ask_level() : nullptr) {
+      n += cancel_level(*lvl);
+      stops_->buys.on_ask_level_became_empty(*lvl);
+    }
+  } else {
+    while (PriceLevel* lvl = ladder_.best_ask_level()) {
+      n += cancel_level(*lvl);
+      level_update(Side::Sell, *lvl);
+      ladder_.on_ask_level_became_empty(*lvl);
+    }
+    while (PriceLevel* lvl = stops_ ? stops_->sells.best_bid_level() : nullptr) {
+      n += cancel_level(*lvl);
+      stops_->sells.on_bid_level_became_empty(*lvl);
+    }
+  }
+
+  flush_cancel_batch();
+  auto_publish();
+  return n;
+}
+
+std::size_t Book::cancel_price_range(Side side, PriceTicks lo, PriceTicks hi) noexcept
+{
+  std::size_t n = 0;
+
+  if (side == Side::Buy) {
+    PriceLevel* lvl = ladder_.best_bid_level();
+    while (lvl && lvl->price_ticks >= lo) {
+      PriceLevel* next = lvl->bid_next;
+      if (lvl->price_ticks <= hi) {
+        n += cancel_level(*lvl);
+        level_update(Side::Buy, *lvl);
+        ladder_.on_bid_level_became_empty(*lvl);
+      }
+      lvl = next;
+    }
+  } else {
+    PriceLevel* lvl = ladder_.best_ask_level();
+    while (lvl && lvl->price_ticks <= hi) {
+      PriceLevel* next = lvl->ask_next;
+      if (lvl->price_ticks >= lo) {
+        n += cancel_level(*lvl);
+        level_update(Side::Sell, *lvl);
+        ladder_.on_ask_level_became_empty(*lvl);
+      }
+      lvl = next;
+    }
+  }
+
+  flush_cancel_batch();
+  auto_publish();
+  return n;
+}
+
+void Book::unlink_from_book(Order& order) noexcept
+{
+  if (order.is_pending_stop()) {
+    unlink_stop(order);
+    return;
+  }
+
+  if (risk_.enabled()) risk_remove(order);
+  state_hash_ -= state_term(order);
+
+  PriceLevel& lvl = ladder_.level_at(order.price_ticks);
+  if (lvl.queue_index != QueuePositionIndex::none) {
+    queue_index_.add(lvl.queue_index, order.queue_slot, -order.qty_remaining, -1);
+  }
+  lvl.erase(&order);
+  level_update(order.side, lvl);
+  if (lvl.total_qty == 0) level_drained(lvl, order.side);
+}
+
+// Lazy cancel: everything that identifies the order as live is undone (id,
+// session, qty, risk, queue position) but the node keeps its place in the
+// queue, so neither the level's neighbours nor the ladder are touched.
+void Book::tombstone(Order& order) noexcept
+{
+  if (risk_.enabled()) risk_remove(order);
+  state_hash_ -= state_term(order);
+
+  PriceLevel& lvl = ladder_.level_at(order.price_ticks);
+  if (lvl.queue_index != QueuePositionIndex::none) {
+    queue_index_.add(lvl.queue_index, order.queue_slot, -order.qty_remaining, -1);
+  }
+
+  lvl.total_qty -= order.qty_remaining;
+  order.qty_remaining = 0;
+  order.hidden_qty = 0;
+  if (order.session != 0) unlink_session(order);
+  id_map_.clear(order.order_id);
+  TombstoneCount& count = tombstones_at(lvl);
+  ++count.tombstones;
+
+  level_update(order.side, lvl);
+  if (lvl.total_qty == 0) {
+    level_drained(lvl, order.side);
+  } else if (count.tombstones >= cfg_.lazy_cancel_compact_at && count.tombstones >= count.compact_at) {
+    compact_level(lvl);
+  }
+}
+
+void Book::reap(PriceLevel& lvl, Order& order) noexcept
+{
+  lvl.erase(&order);
+  pool_.free(&order);
+  --tombstones_at(lvl).tombstones;
+}
+
+// Waiting for as many tombstones as there were live orders keeps the walk
+// amortised O(1) per cancel however deep the level is.
+void Book::compact_level(PriceLevel& lvl) noexcept
+{
+  std::uint32_t live = 0;
+  Order* order = lvl.head;
+  while (order) {
+    Order* next = order->next;
+    if (order->is_live()) ++live;
+    else reap(lvl, *order);
+    order = next;
+  }
+  tombstones_at(lvl).compact_at = live;
+}
+
+// Pool ran dry: give back every tombstone in the book before rejecting.
+void Book::reclaim_tombstones() noexcept
+{
+  for (PriceLevel* lvl = ladder_.best_bid_level(); lvl; lvl = lvl->bid_next) {
+    if (tombstones_at(*lvl).tombstones != 0) compact_level(*lvl);
+  }
+  for (PriceLevel* lvl = ladder_.best_ask_level(); lvl; lvl = lvl->ask_next) {
+    if (tombstones_at(*lvl).tombstones != 0) compact_level(*lvl);
+  }
+}
+
+// No live order left on the level. Any nodes still queued are tombstones and
+// go back to the pool in one chain before the level leaves the ladder.
+void Book::level_drained(PriceLevel& lvl, Side side) noexcept
+{
+  if (cfg_.lazy_cancel) {
+    if (!lvl.empty()) {
+      std::size_t n = 0;
+      for (Order* order = lvl.head; order != nullptr; order = order->next) ++n;
+      pool_.free_chain(lvl.head, lvl.tail, n);
+      lvl.head = nullptr;
+      lvl.tail = nullptr;
+    }
+    tombstones_at(lvl) = {};
+  }
+
+  if (lvl.queue_index != QueuePositionIndex::none) level_emptied(lvl);
+  if (side == Side::Buy) ladder_.on_bid_level_became_empty(lvl);
+  else                  ladder_.on_ask_level_became_empty(lvl);
+}
+
+void Book::release(Order& order) noexcept
+{
+  if (order.session != 0) unlink_session(order);
+  id_map_.clear(order.order_id);
+  pool_.free(&order);
+}
+
+void Book::link_session(Order& order) noexcept
+{
+  Order*& head = session_heads_[order.session];
+  order.session_prev = nullptr;
+  order.session_next = head;
+  if (head) head->session_prev = &order;
+  head = &order;
+}
+
+void Book::unlink_session(Order& order) noexcept
+{
+  if (order.session_prev) order.session_prev->session_next = order.session_next;
+  else session_heads_[order.session] = order.session_next;
+
+  if (order.session_next) order.session_next->session_prev = order.session_prev;
+
+  order.session_prev = nullptr;
+  order.session_next = nullptr;
+}
+
+// Drops a whole queue: one walk to retire ids and session links, then the
+// nodes go back to the pool as a single chain. Leaves the level empty for the
+// caller to take out of its ladder.
+std::size_t Book::cancel_level(PriceLevel& lvl) noexcept
+{
+  std::size_t n = 0;
+  std::size_t nodes = 0;
+  for (Order* order = lvl.head; order != nullptr; order = order->next) {
+    order->prev = nullptr;
+    ++nodes;
+    if (!order->is_live()) continue;  // tombstone, already retired
+
+    if (!order->is_pending_stop()) {
+      if (risk_.enabled()) risk_remove(*order);
+      state_hash_ -= state_term(*order);
+    }
+    if (order->session != 0) unlink_session(*order);
+    id_map_.clear(order->order_id);
+    batch_cancel(order->order_id);
+    ++n;
+  }
+
+  pool_.free_chain(lvl.head, lvl.tail, nodes);
+  lvl.head = nullptr;
+  lvl.tail = nullptr;
+  lvl.total_qty = 0;
+  // Stop ladders share prices but never hold tombstones.
+  if (cfg_.lazy_cancel && &lvl == &ladder_.level_at(lvl.price_ticks)) tombstones_at(lvl) = {};
+  if (lvl.queue_index != QueuePositionIndex::none) queue_untrack(lvl);
+  return n;
+}
+
+void Book::batch_cancel(OrderId order_id) noexcept
+{
+  if (!sink_) return;
+  cancel_batch_.push_back(order_id);
+  if (cancel_batch_.size() == mass_cancel_batch_size) flush_cancel_batch();
+}
+
+void Book::flush_cancel_batch() noexcept
+{
+  if (sink_ && !cancel_batch_.empty()) sink_->on_mass_cancel({cancel_batch_});
+  cancel_batch_.clear();
+}
+
+// A resting order leaving the book unfilled gives back its open notional.
+void Book::risk_remove(const Order& order) noexcept
+{
+  risk_.on_remove(order.account, order.price_ticks, order.qty_remaining + order.hidden_qty);
+}
+
+void Book::level_emptied(PriceLevel& lvl) noexcept
+{
+  queue_index_.release(lvl.queue_index);
+  lvl.queue_index = QueuePositionIndex::none;
+}
+
+void Book::queue_track(PriceLevel& lvl, Order& order) noexcept
+{
+  if (queue_index_.next_slot(lvl.queue_index) == queue_index_.capacity(lvl.queue_index)) {
+    queue_renumber(lvl, order);
+  }
+
+  order.queue_slot = queue_index_.next_slot(lvl.queue_index);
+  queue_index_.set_next_slot(lvl.queue_index, order.queue_slot + 1);
+  queue_index_.add(lvl.queue_index, order.queue_slot, order.qty_remaining, 1);
+}
+
+// Drops the level's block with updates still in it (mass cancel); the level
+// picks up a fresh one when it next becomes non-empty.
+void Book::queue_untrack(PriceLevel& lvl) noexcept
+{
+  queue_index_.clear(lvl.queue_index);
+  level_emptied(lvl);
+}
+
+// Out of slots: pack the orders ahead of `last` (the new tail) into the low
+// slots, doubling the block first unless that frees at least half of it. Either
+// way half the block is free afterwards, which keeps renumbering amortised
+// O(log n) per arrival.
+void Book::queue_renumber(PriceLevel& lvl, const Order& last) noexcept
+{
+  std::uint32_t n = 0;
+  for (const Order* o = lvl.head; o != &last; o = o->next) n += o->is_live() ? 1 : 0;
+  if (n > queue_index_.capacity(lvl.queue_index) / 2) queue_index_.grow(lvl.queue_index);
+  else                                                queue_index_.clear(lvl.queue_index);
+
+  std::uint32_t slot = 0;
+  for (Order* o = lvl.head; o != &last; o = o->next) {
+    if (!o->is_live()) continue;
+    o->queue_slot = slot;
+    queue_index_.add(lvl.queue_index, slot, o->qty_remaining, 1);
+    ++slot;
+  }
+  queue_index_.set_next_slot(lvl.queue_index, slot);
+}
+
+SweepCost Book::sweep_cost(Side side, Qty qty) const noexcept
+{
+  SweepCost cost;
+  const bool buy = side == Side::Buy;
+  for (const PriceLevel* lvl = buy ? ladder_.best_ask_level() : ladder_.best_bid_level();
+       lvl && cost.filled < qty; lvl = buy ? lvl->ask_next : lvl->bid_next) {
+    const Qty take = min_qty(qty - cost.filled, lvl->total_qty);
+    cost.filled += take;
+    cost.notional += take * lvl->price_ticks;
+    cost.worst_price = lvl->price_ticks;
+    ++cost.levels;
+  }
+  return cost;
+}
+
+// The ladder is walked once, only as deep as the largest qty, a chunk of
+// levels at a time. Each chunk's running totals go into fixed-size arrays
+// padded with the max qty, and each qty is placed in them by binary search.
+void Book::sweep_cost(Side side, std::span<const Qty> qtys, std::span<SweepCost> out) const noexcept
+{
+  assert(out.size() >= qtys.size());
+  static constexpr std::size_t chunk = 32;
+
+  Qty largest = 0;
+  for (std::size_t j = 0; j < qtys.size(); ++j) {
+    out[j] = {};
+    if (qtys[j] > largest) largest = qtys[j];
+  }
+
+  Qty cum_qty[chunk];
+  Qty cum_notional[chunk];
+  PriceTicks price[chunk];
+
+  const bool buy = side == Side::Buy;
+  const PriceLevel* lvl = buy ? ladder_.best_ask_level() : ladder_.best_bid_level();
+  Qty base_qty = 0;
+  Qty base_notional = 0;
+  std::size_t base_levels = 0;
+
+  while (lvl && base_qty < largest) {
+    std::size_t n = 0;
+    Qty q = base_qty;
+    Qty notional = base_notional;
+    for (; lvl && n < chunk && q < largest; lvl = buy ? lvl->ask_next : lvl->bid_next, ++n) {
+      q += lvl->total_qty;
+      notional += lvl->total_qty * lvl->price_ticks;
+      cum_qty[n] = q;
+      cum_notional[n] = notional;
+      price[n] = lvl->price_ticks;
+    }
+    for (std::size_t i = n; i < chunk; ++i) cum_qty[i] = std::numeric_limits<Qty>::max();
+
+    for (std::size_t j = 0; j < qtys.size(); ++j) {
+      const Qty want = qtys[j];
+      if (want <= base_qty) continue;  // placed in an earlier chunk
+
+      // Levels in this chunk that end short of want: a fixed-step binary
+      // search, so it compiles to conditional moves.
+      std::size_t k = 0;
+      for (std::size_t step = chunk / 2; step > 0; step /= 2) k += cum_qty[k + step - 1] < want ? step : 0;
+      k += cum_qty[k] < want ? 1 : 0;
+
+      if (k == n) {
+        // Deeper than this chunk: provisional until a later chunk places it,
+        // final if the side runs out here.
+        out[j] = {.filled = cum_qty[n - 1], .notional = cum_notional[n - 1], .worst_price = price[n - 1],
+                  .levels = base_levels + n};
+      } else {
+        const Qty before_qty = k ? cum_qty[k - 1] : base_qty;
+        const Qty before_notional = k ? cum_notional[k - 1] : base_notional;
+        out[j] = {.filled = want, .notional = before_notional + (want - before_qty) * price[k],
+                  .worst_price = price[k], .levels = base_levels + k + 1};
+      }
+    }
+
+    base_qty = q;
+    base_notional = notional;
+    base_levels += n;
+  }
+}
+
+std::optional<QueuePosition> Book::queue_position(OrderId order_id) const noexcept
+{
+  const Order* order = id_map_.get(order_id);
+  if (order == nullptr || order->is_pending_stop()) return std::nullopt;
+
+  const PriceLevel& lvl = ladder_.level_at(order->price_ticks);
+  if (lvl.queue_index != QueuePositionIndex::none) {
+    const auto sum = queue_index_.prefix(lvl.queue_index, order->queue_slot);
+    return QueuePosition{.qty_ahead = sum.qty, .rank = static_cast<std::size_t>(sum.orders)};
+  }
+
+  QueuePosition pos;
+  for (const Order* o = lvl.head; o != order; o = o->next) {
+    if (!o->is_live()) continue;
+    pos.qty_ahead += o->qty_remaining;
+    ++pos.rank;
+  }
+  return pos;
+}
+
+void Book::publish() noexcept
+{
+  const std::size_t depth = cfg_.publish_depth;
+  if (depth == 0 || !publish_dirty_) return;
+  publish_dirty_ = false;
+
+  BookSnapshot snap;
+  snap.sequence = ++publish_seq_;
+  if (last_trade_price_) {
+    snap.last_trade_price = *last_trade_price_;
+    snap.has_last_trade = 1;
+  }
+
+  std::uint32_t n = 0;
+  for (PriceLevel* lvl = ladder_.best_bid_level(); lvl && n < depth; lvl = lvl->bid_next) {
+    snap.bids[n++] = {.price_ticks = lvl->price_ticks, .qty = lvl->total_qty};
+  }
+  snap.bid_depth = n;
+  publish_bid_floor_ = n == depth ? snap.bids[n - 1].price_ticks : std::numeric_limits<PriceTicks>::min();
+
+  n = 0;
+  for (PriceLevel* lvl = ladder_.best_ask_level(); lvl && n < depth; lvl = lvl->ask_next) {
+    snap.asks[n++] = {.price_ticks = lvl->price_ticks, .qty = lvl->total_qty};
+  }
+  snap.ask_depth = n;
+  publish_ask_ceiling_ = n == depth ? snap.asks[n - 1].price_ticks : std::numeric_limits<PriceTicks>::max();
+
+  snapshot_.store(snap);
+}
 }
@@ -30,51 +30,56 @@ PriceLevel& Ladder::level_at(PriceTicks p) noexcept {
   return levels_[index_of(p)];
 }
 
-PriceLevel* Ladder::best_bid_level() const noexcept { return best_bid_; }
-PriceLevel* Ladder::best_ask_level() const noexcept { return best_ask_; }
+const PriceLevel& Ladder::level_at(PriceTicks p) const noexcept {
+  assert(is_valid_price(p));
+  return levels_[index_of(p)];
+}
+
+PriceLevel* Ladder::best_bid_level() const noexcept { return chains_.best_bid; }
+PriceLevel* Ladder::best_ask_level() const noexcept { return chains_.best_ask; }
 
 void Ladder::on_bid_level_became_non_empty(PriceLevel& lvl) noexcept {
   assert(!lvl.empty());
   if (lvl.in_bid) return;
-  bid_insert_sorted(lvl);
+  chains_.bid_insert_sorted(lvl);
 }
 
 void Ladder::on_bid_level_became_empty(PriceLevel& lvl) noexcept {
   assert(lvl.empty());
   if (!lvl.in_bid) return;
-  bid_erase(lvl);
+  chains_.bid_erase(lvl);
 }
 
 void Ladder::on_ask_level_became_non_empty(PriceLevel& lvl) noexcept {
   assert(!lvl.empty());
   if (lvl.in_ask) return;
-  ask_insert_sorted(lvl);
+  chains_.ask_insert_sorted(lvl);
 }
 
 void Ladder::on_ask_level_became_empty(PriceLevel& lvl) noexcept {
   assert(lvl.empty());
   if (!lvl.in_ask) return;
-  ask_erase(lvl);
+  chains_.ask_erase(lvl);
 }
 
-void Ladder::bid_insert_sorted(PriceLevel& lvl) noexcept {
+void LevelChains::bid_insert_sorted(PriceLevel& lvl) noexcept {
   lvl.in_bid = true;
   lvl.bid_prev = nullptr;
   lvl.bid_next = nullptr;
 
-  if (!best_bid_) {
-      best_bid_ = &lvl;
+  if (!best_bid) {
+      best_bid = &lvl;
       return;
   }
 
-  if (lvl.price_ticks > best_bid_->price_ticks) {
-    lvl.bid_next = best_bid_;
-    best_bid_->bid_prev = &lvl;
-    best_bid_ = &lvl;
+  if (lvl.price_ticks > best_bid->price_ticks) {
+    lvl.bid_next = best_bid;
+    best_bid->bid_prev = &lvl;
+    best_bid = &lvl;
     return;
   }
   
-  PriceLevel* cur = best_bid_;
+  PriceLevel* cur = best_bid;
   while (cur->bid_next && cur->bid_next->price_ticks >= lvl.price_ticks) {
     cur = cur->bid_next;
   }
@@ -86,24 +91,24 @@ void Ladder::bid_insert_sorted(PriceLevel& lvl) noexcept {
   cur->bid_next = &lvl;
 }
 
-void Ladder::ask_insert_sorted(PriceLevel& lvl) noexcept {
+void LevelChains::ask_insert_sorted(PriceLevel& lvl) noexcept {
   lvl.in_ask = true;
   lvl.ask_prev = nullptr;
   lvl.ask_next = nullptr;
 
-  if (!best_ask_) {
-    best_ask_ = &lvl;
+  if (!best_ask) {
+    best_ask = &lvl;
     return;
   }
 
-  if (lvl.price_ticks < best_ask_->price_ticks) {
-    lvl.ask_next = best_ask_;
-    best_ask_->ask_prev = &lvl;
-    best_ask_ = &lvl;
+  if (lvl.price_ticks < best_ask->price_ticks) {
+    lvl.ask_next = best_ask;
+    best_ask->ask_prev = &lvl;
+    best_ask = &lvl;
     return;
   }
 
-  PriceLevel* cur = best_ask_;
+  PriceLevel* cur = best_ask;
   while (cur->ask_next && cur->ask_next->price_ticks <= lvl.price_ticks) {
     cur = cur->ask_next;
   }
@@ -115,9 +120,9 @@ void Ladder::ask_insert_sorted(PriceLevel& lvl) noexcept {
   cur->ask_next = &lvl;
 }
 
-void Ladder::bid_erase(PriceLevel& lvl) noexcept {
+void LevelChains::bid_erase(PriceLevel& lvl) noexcept {
   if (lvl.bid_prev) lvl.bid_prev->bid_next = lvl.bid_next;
-  else best_bid_ = lvl.bid_next;
+  else best_bid = lvl.bid_next;
 
   if (lvl.bid_next) lvl.bid_next->bid_prev = lvl.bid_prev;
 
@@ -126,9 +131,9 @@ void Ladder::bid_erase(PriceLevel& lvl) noexcept {
   lvl.in_bid = false;
 }
 
-void Ladder::ask_erase(PriceLevel& lvl) noexcept {
+void LevelChains::ask_erase(PriceLevel& lvl) noexcept {
   if (lvl.ask_prev) lvl.ask_prev->ask_next = lvl.ask_next;
-  else best_ask_ = lvl.ask_next;
+  else best_ask = lvl.ask_next;
 
   if (lvl.ask_next) lvl.ask_next->ask_prev = lvl.ask_prev;
 
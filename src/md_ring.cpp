@@ -0,0 +1,138 @@
+#include "clob/md_ring.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cstdio>
+#include <new>
+
+namespace clob {
+
+static constexpr std::size_t max_name_length = 62;
+
+static inline std::size_t ring_map_size(std::size_t capacity) noexcept
+{
+  return sizeof(MdRingHeader) + capacity * sizeof(MdSlot);
+}
+
+// shm_open wants a leading slash and no others.
+static inline bool make_shm_name(std::string_view name, char (&out)[64]) noexcept
+{
+  if (name.empty() || name.size() > max_name_length) return false;
+  if (name.find('/') != std::string_view::npos) return false;
+
+  std::snprintf(out, sizeof(out), "/%.*s", static_cast<int>(name.size()), name.data());
+  return true;
+}
+
+std::uint64_t md_now_ns() noexcept
+{
+  timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+MdRingWriter::~MdRingWriter()
+{
+  if (header_) {
+    ::munmap(header_, map_size_);
+    ::shm_unlink(name_);
+  }
+}
+
+MdRingResult MdRingWriter::create(std::string_view name, std::size_t capacity)
+{
+  if (header_) return {.ok = false, .error = "already open"};
+  if (capacity == 0) return {.ok = false, .error = "capacity == 0"};
+  if (!make_shm_name(name, name_)) return {.ok = false, .error = "invalid name"};
+
+  capacity = std::bit_ceil(capacity);
+  const std::size_t size = ring_map_size(capacity);
+
+  ::shm_unlink(name_);
+  const int fd = ::shm_open(name_, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) return {.ok = false, .error = "shm_open failed"};
+
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name_);
+    return {.ok = false, .error = "ftruncate failed"};
+  }
+
+  void* mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) {
+    ::shm_unlink(name_);
+    return {.ok = false, .error = "mmap failed"};
+  }
+
+  // A fresh object is zero-filled, so every slot starts out as "not written".
+  auto* header = new (mem) MdRingHeader{};
+  header->record_size = sizeof(MdRecord);
+  header->slot_size = sizeof(MdSlot);
+  header->capacity = capacity;
+  header->write_cursor.store(0, std::memory_order_relaxed);
+  slots_ = reinterpret_cast<MdSlot*>(static_cast<unsigned char*>(mem) + sizeof(MdRingHeader));
+
+  // Readers check the magic last, so they never see a half-initialised header.
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = MdRingHeader::magic_value;
+
+  header_ = header;
+  mask_ = capacity - 1;
+  cursor_ = 0;
+  map_size_ = size;
+  return {.ok = true, .error = {}};
+}
+
+MdRingReader::~MdRingReader()
+{
+  if (header_) ::munmap(const_cast<MdRingHeader*>(header_), map_size_);
+}
+
+MdRingResult MdRingReader::open(std::string_view name)
+{
+  if (header_) return {.ok = false, .error = "already open"};
+
+  char shm_name[64];
+  if (!make_shm_name(name, shm_name)) return {.ok = false, .error = "invalid name"};
+
+  const int fd = ::shm_open(shm_name, O_RDONLY, 0);
+  if (fd < 0) return {.ok = false, .error = "shm_open failed"};
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(MdRingHeader)) {
+    ::close(fd);
+    return {.ok = false, .error = "ring not initialised"};
+  }
+
+  const auto size = static_cast<std::size_t>(st.st_size);
+  void* mem = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) return {.ok = false, .error = "mmap failed"};
+
+  const auto* header = static_cast<const MdRingHeader*>(mem);
+  const bool valid = header->magic == MdRingHeader::magic_value
+                  && header->record_size == sizeof(MdRecord)
+                  && header->slot_size == sizeof(MdSlot)
+                  && std::has_single_bit(header->capacity)
+                  && ring_map_size(header->capacity) <= size;
+  if (!valid) {
+    ::munmap(mem, size);
+    return {.ok = false, .error = "ring layout mismatch"};
+  }
+
+  header_ = header;
+  slots_ = reinterpret_cast<const MdSlot*>(static_cast<const unsigned char*>(mem) + sizeof(MdRingHeader));
+  mask_ = header->capacity - 1;
+  cursor_ = header->write_cursor.load(std::memory_order_acquire);
+  lost_ = 0;
+  map_size_ = size;
+  return {.ok = true, .error = {}};
+}
+
+} // namespace clob
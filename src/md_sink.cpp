@@ -0,0 +1,65 @@
+#include "clob/md_sink.hpp"
+
+namespace clob {
+
+inline void MdRingSink::push(MdRecord& record) noexcept
+{
+  if (stamp_) record.ts_ns = md_now_ns();
+  ring_.push(record);
+}
+
+void MdRingSink::on_ack_add(const Book::AckAddEvent& e)
+{
+  MdRecord r{.order_id = e.order_id, .type = MdRecordType::AckAdd};
+  push(r);
+}
+
+void MdRingSink::on_reject_add(const Book::RejectAddEvent& e)
+{
+  MdRecord r{.order_id = e.order_id, .type = MdRecordType::RejectAdd};
+  push(r);
+}
+
+void MdRingSink::on_ack_cancel(const Book::AckCancelEvent& e)
+{
+  MdRecord r{.order_id = e.order_id, .type = MdRecordType::AckCancel};
+  push(r);
+}
+
+void MdRingSink::on_reject_cancel(const Book::RejectCancelEvent& e)
+{
+  MdRecord r{.order_id = e.order_id, .type = MdRecordType::RejectCancel};
+  push(r);
+}
+
+void MdRingSink::on_trade(const Book::TradeEvent& e)
+{
+  MdRecord r{.qty = e.qty, .price_ticks = e.price, .order_id = e.resting_id, .other_id = e.incoming_id,
+             .type = MdRecordType::Trade};
+  push(r);
+}
+
+void MdRingSink::on_done(const Book::DoneEvent& e)
+{
+  MdRecord r{.order_id = e.order_id, .type = MdRecordType::Done};
+  push(r);
+}
+
+void MdRingSink::on_mass_cancel(const Book::MassCancelEvent& e)
+{
+  MdRecord r{.type = MdRecordType::AckCancel};
+  if (stamp_) r.ts_ns = md_now_ns();
+  for (OrderId order_id : e.order_ids) {
+    r.order_id = order_id;
+    ring_.push(r);
+  }
+}
+
+void MdRingSink::on_level_update(const Book::LevelUpdateEvent& e)
+{
+  MdRecord r{.qty = e.qty, .price_ticks = e.price, .type = MdRecordType::LevelUpdate,
+             .side = static_cast<std::uint8_t>(e.side)};
+  push(r);
+}
+
+} // namespace clob
@@ -5,38 +5,72 @@
 
 namespace clob {
 
-OrderPool::OrderPool(std::size_t capacity)
-  : storage_(capacity)
+OrderPool::OrderPool(std::size_t capacity, std::size_t segment_size, std::size_t low_water)
+  : segment_size_(segment_size)
+  , low_water_(low_water)
 {
-  for (auto& node : storage_) {
-    node.prev = nullptr;
-    node.next = free_head_;
-    free_head_ = &node;
-    ++free_count_;
-  }
+  bump_ = new_segment(capacity);
+  bump_end_ = bump_ + capacity;
+  capacity_.store(capacity, std::memory_order_relaxed);
+  set_free_count(capacity);
 
-  assert(free_count_ == storage_.size());
+  if (segment_size_ > 0) {
+    spare_.store(new_segment(segment_size_), std::memory_order_release);
+  }
 }
 
-Order* OrderPool::allocate()
+OrderPool::~OrderPool() = default;
+
+Order* OrderPool::new_segment(std::size_t n)
 {
-  if (free_head_ == nullptr) {
+  if (n == 0) {
     return static_cast<Order*>(nullptr);
   }
 
+  auto segment = std::make_unique<Order[]>(n);
+  Order* nodes = segment.get();
+
+  std::lock_guard<std::mutex> lock(segments_mutex_);
+  segments_.push_back(std::move(segment));
+  return nodes;
+}
+
+Order* OrderPool::allocate()
+{
   Order* node = free_head_;
 
-  node->prev = nullptr;
-  node->next = nullptr;
+  if (node != nullptr) {
+    free_head_ = node->next;
+  } else {
+    if (bump_ == bump_end_) {
+      Order* spare = spare_.exchange(nullptr, std::memory_order_acquire);
+      if (spare == nullptr) {
+        return static_cast<Order*>(nullptr);
+      }
+      bump_ = spare;
+      bump_end_ = spare + segment_size_;
+      capacity_.store(capacity() + segment_size_, std::memory_order_relaxed);
+      set_free_count(free_count() + segment_size_);
+    }
+    node = bump_++;
+  }
 
-  free_head_ = node->next;
+  node->prev = nullptr;
   node->next = nullptr;
   node->order_id = 0;
+  node->kind = OrderKind::Limit;
   node->qty_remaining = 0;
+  node->display_qty = 0;
+  node->hidden_qty = 0;
   node->time_seq = 0;
+  node->session = 0;
+  node->queue_slot = 0;
+  node->account = 0;
+  node->session_prev = nullptr;
+  node->session_next = nullptr;
 
-  assert(free_count_ > 0);
-  --free_count_;
+  assert(free_count() > 0);
+  set_free_count(free_count() - 1);
 
   return node;
 }
@@ -53,17 +87,41 @@ void OrderPool::free(Order* order)
   order->prev = nullptr;
 
   free_head_ = order;
-  ++free_count_;
+  set_free_count(free_count() + 1);
 }
 
-auto OrderPool::capacity() const noexcept 
+// Returns a run of nodes still linked through next (prev already cleared) in
+// one splice.
+void OrderPool::free_chain(Order* head, Order* tail, std::size_t count)
 {
-  return storage_.size();
+  if (head == nullptr) {
+    return;
+  }
+
+  assert(tail != nullptr && tail->next == nullptr);
+
+  tail->next = free_head_;
+  free_head_ = head;
+  set_free_count(free_count() + count);
+}
+
+bool OrderPool::needs_refill() const noexcept
+{
+  return segment_size_ > 0
+      && spare_.load(std::memory_order_relaxed) == nullptr
+      && free_count() <= low_water_;
 }
 
-auto OrderPool::free_count() const noexcept
+// Housekeeping side of the pool: safe to call from any one thread while the
+// owner keeps allocating. Only this path touches the heap.
+bool OrderPool::refill()
 {
-  return free_count_;
+  if (!needs_refill()) {
+    return false;
+  }
+
+  spare_.store(new_segment(segment_size_), std::memory_order_release);
+  return true;
 }
 
 OrderIdMap::OrderIdMap(std::size_t max_orders)
@@ -97,12 +155,7 @@ void OrderIdMap::clear(OrderId order_id) noexcept
 
 bool OrderIdMap::exists(OrderId order_id) const noexcept
 {
-  return by_id_[order_id] != nullptr;
-}
-
-auto OrderIdMap::max_id() const noexcept
-{
-  return by_id_.size() - 1;
+  return order_id < by_id_.size() && by_id_[order_id] != nullptr;
 }
 
 }
@@ -19,6 +19,7 @@ void PriceLevel::push_back(Order* order) noexcept {
     head = order;
   }
   tail = order;
+  total_qty += order->qty_remaining;
 }
 
 Order* PriceLevel::pop_front() noexcept {
@@ -35,6 +36,7 @@ Order* PriceLevel::pop_front() noexcept {
 
   order->prev = nullptr;
   order->next = nullptr;
+  total_qty -= order->qty_remaining;
   return order;
 }
 
@@ -55,6 +57,16 @@ void PriceLevel::erase(Order* order) noexcept {
 
   order->prev = nullptr;
   order->next = nullptr;
+  total_qty -= order->qty_remaining;
+}
+
+void PriceLevel::move_to_back(Order* order) noexcept {
+  assert(order);
+
+  if (order == tail) return;
+
+  erase(order);
+  push_back(order);
 }
 
 } // namespace clob
@@ -0,0 +1,73 @@
+#include "clob/queue_position.hpp"
+
+#include <algorithm>
+#include <cassert>
+
+namespace clob {
+
+QueuePositionIndex::QueuePositionIndex(std::size_t blocks, std::uint32_t slots_per_block)
+  : slots_(slots_per_block)
+  , trees_(std::min(blocks, max_blocks), std::vector<Sum>(slots_per_block))
+  , next_slot_(std::min(blocks, max_blocks), 0)
+{
+  blocks = std::min(blocks, max_blocks);
+  free_blocks_.reserve(blocks);
+  for (std::size_t i = blocks; i > 0; --i) {
+    free_blocks_.push_back(static_cast<std::uint16_t>(i - 1));
+  }
+}
+
+std::uint16_t QueuePositionIndex::acquire() noexcept
+{
+  if (free_blocks_.empty() || slots_ == 0) return none;
+
+  const std::uint16_t block = free_blocks_.back();
+  free_blocks_.pop_back();
+  return block;
+}
+
+void QueuePositionIndex::release(std::uint16_t block) noexcept
+{
+  assert(block != none);
+  next_slot_[block] = 0;
+  trees_[block].resize(slots_);
+  free_blocks_.push_back(block);
+}
+
+void QueuePositionIndex::clear(std::uint16_t block) noexcept
+{
+  std::fill(trees_[block].begin(), trees_[block].end(), Sum{});
+}
+
+void QueuePositionIndex::grow(std::uint16_t block) noexcept
+{
+  auto& tree = trees_[block];
+  tree.assign(tree.size() * 2, Sum{});
+}
+
+void QueuePositionIndex::add(std::uint16_t block, std::uint32_t slot, Qty qty, std::int64_t orders) noexcept
+{
+  const std::uint32_t n = capacity(block);
+  assert(slot < n);
+
+  Sum* base = trees_[block].data();
+  for (std::uint32_t i = slot + 1; i <= n; i += i & (0u - i)) {
+    base[i - 1].qty += qty;
+    base[i - 1].orders += orders;
+  }
+}
+
+QueuePositionIndex::Sum QueuePositionIndex::prefix(std::uint16_t block, std::uint32_t slot) const noexcept
+{
+  assert(slot <= capacity(block));
+
+  const Sum* base = trees_[block].data();
+  Sum sum;
+  for (std::uint32_t i = slot; i > 0; i -= i & (0u - i)) {
+    sum.qty += base[i - 1].qty;
+    sum.orders += base[i - 1].orders;
+  }
+  return sum;
+}
+
+} // namespace clob
@@ -0,0 +1,211 @@
+#include "clob/replication.hpp"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <bit>
+#include <cstdio>
+#include <new>
+
+namespace clob {
+
+static constexpr std::size_t max_name_length = 62;
+
+static inline std::size_t ring_map_size(std::size_t capacity) noexcept
+{
+  return sizeof(ReplRingHeader) + capacity * sizeof(ReplSlot);
+}
+
+// shm_open wants a leading slash and no others.
+static inline bool make_shm_name(std::string_view name, char (&out)[64]) noexcept
+{
+  if (name.empty() || name.size() > max_name_length) return false;
+  if (name.find('/') != std::string_view::npos) return false;
+
+  std::snprintf(out, sizeof(out), "/%.*s", static_cast<int>(name.size()), name.data());
+  return true;
+}
+
+std::uint64_t repl_now_ns() noexcept
+{
+  timespec ts;
+  ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<std::uint64_t>(ts.tv_sec) * 1'000'000'000ull + static_cast<std::uint64_t>(ts.tv_nsec);
+}
+
+ReplWriter::~ReplWriter()
+{
+  if (header_) {
+    ::munmap(header_, map_size_);
+    ::shm_unlink(name_);
+  }
+}
+
+ReplResult ReplWriter::create(std::string_view name, std::size_t capacity)
+{
+  if (header_) return {.ok = false, .error = "already open"};
+  if (capacity == 0) return {.ok = false, .error = "capacity == 0"};
+  if (!make_shm_name(name, name_)) return {.ok = false, .error = "invalid name"};
+
+  capacity = std::bit_ceil(capacity);
+  const std::size_t size = ring_map_size(capacity);
+
+  ::shm_unlink(name_);
+  const int fd = ::shm_open(name_, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) return {.ok = false, .error = "shm_open failed"};
+
+  if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+    ::close(fd);
+    ::shm_unlink(name_);
+    return {.ok = false, .error = "ftruncate failed"};
+  }
+
+  void* mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) {
+    ::shm_unlink(name_);
+    return {.ok = false, .error = "mmap failed"};
+  }
+
+  // A fresh object is zero-filled: no slot holds a command yet.
+  auto* header = new (mem) ReplRingHeader{};
+  header->command_size = sizeof(ReplCommand);
+  header->slot_size = sizeof(ReplSlot);
+  header->capacity = capacity;
+  header->write_seq.store(0, std::memory_order_relaxed);
+  header->ack_seq.store(0, std::memory_order_relaxed);
+  slots_ = reinterpret_cast<ReplSlot*>(static_cast<unsigned char*>(mem) + sizeof(ReplRingHeader));
+
+  // The replica checks the magic last, so it never sees a half-initialised header.
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic = ReplRingHeader::magic_value;
+
+  header_ = header;
+  mask_ = capacity - 1;
+  seq_ = 0;
+  acked_ = 0;
+  map_size_ = size;
+  return {.ok = true, .error = {}};
+}
+
+Replica::~Replica()
+{
+  if (header_) ::munmap(header_, map_size_);
+}
+
+ReplResult Replica::open(std::string_view name)
+{
+  if (header_) return {.ok = false, .error = "already open"};
+
+  char shm_name[64];
+  if (!make_shm_name(name, shm_name)) return {.ok = false, .error = "invalid name"};
+
+  // Read-write: the replica publishes its ack in the header.
+  const int fd = ::shm_open(shm_name, O_RDWR, 0);
+  if (fd < 0) return {.ok = false, .error = "shm_open failed"};
+
+  struct stat st;
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(ReplRingHeader)) {
+    ::close(fd);
+    return {.ok = false, .error = "ring not initialised"};
+  }
+
+  const auto size = static_cast<std::size_t>(st.st_size);
+  void* mem = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (mem == MAP_FAILED) return {.ok = false, .error = "mmap failed"};
+
+  auto* header = static_cast<ReplRingHeader*>(mem);
+  const bool valid = header->magic == ReplRingHeader::magic_value
+                  && header->command_size == sizeof(ReplCommand)
+                  && header->slot_size == sizeof(ReplSlot)
+                  && std::has_single_bit(header->capacity)
+                  && ring_map_size(header->capacity) <= size;
+  if (!valid) {
+    ::munmap(mem, size);
+    return {.ok = false, .error = "ring layout mismatch"};
+  }
+
+  header_ = header;
+  slots_ = reinterpret_cast<const ReplSlot*>(static_cast<const unsigned char*>(mem) + sizeof(ReplRingHeader));
+  mask_ = header->capacity - 1;
+  applied_ = header->ack_seq.load(std::memory_order_acquire);
+  map_size_ = size;
+  return {.ok = true, .error = {}};
+}
+
+std::size_t Replica::poll(std::size_t max_commands) noexcept
+{
+  std::size_t n = 0;
+  while (n < max_commands) {
+    const std::uint64_t want = applied_ + 1;
+    const ReplSlot& slot = slots_[want & mask_];
+    if (slot.seq.load(std::memory_order_acquire) != want) break;
+
+    // The primary will not reuse the slot before it is acked.
+    if (!diverged_at_ && slot.command.state_hash != book_.state_hash()) diverged_at_ = want;
+    apply(slot.command);
+    last_ts_ns_ = slot.command.ts_ns;
+    applied_ = want;
+    ++n;
+  }
+
+  if (n != 0) header_->ack_seq.store(applied_, std::memory_order_release);
+  return n;
+}
+
+std::size_t Replica::drain() noexcept
+{
+  std::size_t n = 0;
+  while (applied_ < published()) n += poll(~std::size_t{0});
+  return n;
+}
+
+void Replica::apply(const ReplCommand& c) noexcept
+{
+  switch (c.type) {
+    case ReplCommandType::AddLimit:
+      (void)book_.add_limit(c.order_id, c.qty, c.side, c.price_ticks, c.session);
+      break;
+    case ReplCommandType::AddIceberg:
+      (void)book_.add_iceberg(c.order_id, c.qty, c.side, c.price_ticks, c.display_qty, c.session);
+      break;
+    case ReplCommandType::AddStop:
+      (void)book_.add_stop(c.order_id, c.qty, c.side, c.price_ticks, c.session);
+      break;
+    case ReplCommandType::AddStopLimit:
+      (void)book_.add_stop_limit(c.order_id, c.qty, c.side, c.price_ticks, c.aux_price_ticks, c.session);
+      break;
+    case ReplCommandType::Cancel:
+      (void)book_.cancel(c.order_id);
+      break;
+    case ReplCommandType::CancelSession:
+      (void)book_.cancel_session(c.session);
+      break;
+    case ReplCommandType::CancelSide:
+      (void)book_.cancel_side(c.side);
+      break;
+    case ReplCommandType::CancelPriceRange:
+      (void)book_.cancel_price_range(c.side, c.price_ticks, c.aux_price_ticks);
+      break;
+    case ReplCommandType::SetRiskLimits: {
+      const std::uint64_t position = std::uint64_t{c.aux_hi} << 32 | static_cast<std::uint32_t>(c.aux_price_ticks);
+      (void)book_.set_risk_limits(c.order_id, {.max_order_qty = c.qty,
+                                               .max_open_notional = c.display_qty,
+                                               .max_position = static_cast<Qty>(position),
+                                               .price_band = c.price_ticks});
+      break;
+    }
+    case ReplCommandType::SetSessionAccount:
+      (void)book_.set_session_account(c.session, c.order_id);
+      break;
+    case ReplCommandType::RefillPool:
+      (void)book_.refill_pool();
+      break;
+  }
+}
+
+} // namespace clob
@@ -0,0 +1,32 @@
+#include "clob/risk.hpp"
+
+namespace clob {
+
+RiskTable::RiskTable(std::size_t max_accounts, std::size_t max_sessions)
+  : enabled_(max_accounts != 0)
+  , accounts_(max_accounts)
+  , session_account_(max_accounts != 0 ? max_sessions : 0, AccountId{0})
+{
+}
+
+bool RiskTable::set_limits(AccountId account, const RiskLimits& limits) noexcept
+{
+  if (account >= accounts_.size()) return false;
+  accounts_[account].limits = limits;
+  return true;
+}
+
+bool RiskTable::set_session_account(SessionId session, AccountId account) noexcept
+{
+  if (session >= session_account_.size() || account >= accounts_.size()) return false;
+  session_account_[session] = account;
+  return true;
+}
+
+RiskState RiskTable::state(AccountId account) const noexcept
+{
+  if (account >= accounts_.size()) return {};
+  return accounts_[account].state;
+}
+
+} // namespace clob
@@ -0,0 +1,63 @@
+#include "clob/trade_analytics.hpp"
+
+namespace clob {
+
+static inline std::size_t grid_size(const LadderConfig& ladder) noexcept
+{
+  if (ladder.max_price_ticks < ladder.min_price_ticks) return 0;
+  return static_cast<std::size_t>(std::int64_t{ladder.max_price_ticks} - ladder.min_price_ticks + 1);
+}
+
+TradeAnalytics::TradeAnalytics(AnalyticsConfig cfg)
+  : cfg_(cfg)
+  , grid_min_(cfg.ladder.min_price_ticks)
+  , grid_size_(grid_size(cfg.ladder))
+  , volume_at_price_(grid_size_, Qty{0})
+  , bars_(cfg.bar_interval_ns != 0 || cfg.bar_volume > 0)
+  , time_bars_(cfg.bar_interval_ns != 0 ? cfg.bar_history : 1)
+  , volume_bars_(cfg.bar_volume > 0 ? cfg.bar_history : 1)
+{
+  if (cfg_.bar_volume < 0) cfg_.bar_volume = 0;
+}
+
+void TradeAnalytics::add_to_bars(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept
+{
+  if (cfg_.bar_interval_ns != 0) {
+    // time_bar_end_ is 0 until the first bar opens; after that a bar is always open.
+    if (ts_ns < time_bar_end_) time_bars_.current_.extend(price, qty, ts_ns);
+    else start_time_bar(price, qty, ts_ns);
+  }
+
+  if (cfg_.bar_volume != 0) {
+    Bar& bar = volume_bars_.current_;
+    if (bar.volume + qty < cfg_.bar_volume) bar.add(price, qty, ts_ns);
+    else add_volume_bars(price, qty, ts_ns);
+  }
+}
+
+void TradeAnalytics::start_time_bar(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept
+{
+  if (time_bars_.current_.trades != 0) time_bars_.close();
+
+  const std::uint64_t start = ts_ns - ts_ns % cfg_.bar_interval_ns;
+  const std::uint64_t max_ts = ~std::uint64_t{0};
+  time_bar_end_ = start <= max_ts - cfg_.bar_interval_ns ? start + cfg_.bar_interval_ns : max_ts;
+  time_bars_.current_.add(price, qty, ts_ns);
+  time_bars_.current_.start_ns = start;
+}
+
+// The trade fills the open bar up to bar_volume, closing it, and whatever is
+// left opens the next ones at the same price and stamp.
+void TradeAnalytics::add_volume_bars(PriceTicks price, Qty qty, std::uint64_t ts_ns) noexcept
+{
+  while (qty > 0) {
+    Bar& bar = volume_bars_.current_;
+    const Qty room = cfg_.bar_volume - bar.volume;
+    const Qty take = qty < room ? qty : room;
+    bar.add(price, take, ts_ns);
+    qty -= take;
+    if (bar.volume == cfg_.bar_volume) volume_bars_.close();
+  }
+}
+
+} // namespace clob